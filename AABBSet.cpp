@@ -0,0 +1,104 @@
+#include "AABBSet.hpp"
+
+#include <cassert>
+#include <cstring>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define AABBSET_SSE 1
+#include <emmintrin.h>
+#endif
+
+//empty boxes have min > max, so no query can overlap them:
+static constexpr float EmptyMin = std::numeric_limits< float >::infinity();
+static constexpr float EmptyMax = -std::numeric_limits< float >::infinity();
+
+void AABBSet::clear() {
+	resize(0);
+}
+
+void AABBSet::resize(size_t count_) {
+	count = count_;
+	size_t padded = (count + Lanes - 1) / Lanes * Lanes;
+	min_x.assign(padded, EmptyMin);
+	min_y.assign(padded, EmptyMin);
+	max_x.assign(padded, EmptyMax);
+	max_y.assign(padded, EmptyMax);
+}
+
+void AABBSet::set(size_t i, float x, float y, float w, float h) {
+	assert(i < count);
+	min_x[i] = x;
+	min_y[i] = y;
+	max_x[i] = x + w;
+	max_y[i] = y + h;
+}
+
+void AABBSet::set_empty(size_t i) {
+	assert(i < count);
+	min_x[i] = min_y[i] = EmptyMin;
+	max_x[i] = max_y[i] = EmptyMax;
+}
+
+size_t AABBSet::add(float x, float y, float w, float h) {
+	size_t i = count;
+	count += 1;
+	if (count > min_x.size()) {
+		min_x.resize(min_x.size() + Lanes, EmptyMin);
+		min_y.resize(min_y.size() + Lanes, EmptyMin);
+		max_x.resize(max_x.size() + Lanes, EmptyMax);
+		max_y.resize(max_y.size() + Lanes, EmptyMax);
+	}
+	set(i, x, y, w, h);
+	return i;
+}
+
+void AABBSet::overlaps_scalar(float x, float y, float w, float h, uint32_t *mask) const {
+	std::memset(mask, 0, mask_words() * sizeof(uint32_t));
+	float x1 = x + w;
+	float y1 = y + h;
+	for (size_t i = 0; i < count; ++i) {
+		if (x < max_x[i] && x1 > min_x[i] && y < max_y[i] && y1 > min_y[i]) {
+			mask[i / 32] |= (1u << (i % 32));
+		}
+	}
+}
+
+#ifdef AABBSET_SSE
+void AABBSet::overlaps(float x, float y, float w, float h, uint32_t *mask) const {
+	static_assert(Lanes == 4, "SSE kernel tests four boxes per step");
+	std::memset(mask, 0, mask_words() * sizeof(uint32_t));
+	__m128 qx0 = _mm_set1_ps(x);
+	__m128 qy0 = _mm_set1_ps(y);
+	__m128 qx1 = _mm_set1_ps(x + w);
+	__m128 qy1 = _mm_set1_ps(y + h);
+	//(padding boxes never hit, so running to the padded size is safe; bits past 'count' stay clear)
+	for (size_t i = 0; i < min_x.size(); i += 4) {
+		__m128 hit = _mm_and_ps(
+			_mm_and_ps(_mm_cmplt_ps(qx0, _mm_loadu_ps(&max_x[i])), _mm_cmpgt_ps(qx1, _mm_loadu_ps(&min_x[i]))),
+			_mm_and_ps(_mm_cmplt_ps(qy0, _mm_loadu_ps(&max_y[i])), _mm_cmpgt_ps(qy1, _mm_loadu_ps(&min_y[i])))
+		);
+		uint32_t bits = uint32_t(_mm_movemask_ps(hit));
+		if (bits) mask[i / 32] |= bits << (i % 32);
+	}
+}
+
+char const *AABBSet::kernel() {
+	return "sse";
+}
+#else
+void AABBSet::overlaps(float x, float y, float w, float h, uint32_t *mask) const {
+	overlaps_scalar(x, y, w, h, mask);
+}
+
+char const *AABBSet::kernel() {
+	return "scalar";
+}
+#endif
+
+uint32_t AABBSet::overlap_mask(float x, float y, float w, float h) const {
+	assert(count <= 32);
+	uint32_t mask = 0;
+	overlaps(x, y, w, h, &mask);
+	return mask;
+}
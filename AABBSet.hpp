@@ -0,0 +1,54 @@
+#pragma once
+
+/*
+ * AABBSet stores axis-aligned boxes as a structure of arrays (one array per
+ * edge) so that one query box can be tested against many boxes at once with
+ * SIMD compares.
+ *
+ * Queries return a hit mask: bit (i % 32) of mask[i / 32] is set when box i
+ * overlaps the query box. Boxes that exactly touch an edge don't count as
+ * overlapping (same as Level::overlap).
+ *
+ * The arrays are padded to a multiple of Lanes with empty boxes, which never
+ * hit anything, so the kernel never needs a scalar tail loop.
+ */
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+struct AABBSet {
+	static constexpr size_t Lanes = 4; //boxes tested per SIMD step
+
+	//number of boxes:
+	size_t size() const { return count; }
+	//number of uint32_t words in a hit mask for this set:
+	size_t mask_words() const { return (count + 31) / 32; }
+
+	//remove all boxes:
+	void clear();
+	//make the set hold 'count' empty boxes (which never hit anything):
+	void resize(size_t count);
+	//set box i to have corner (x,y) and size (w,h):
+	void set(size_t i, float x, float y, float w, float h);
+	//mark box i as empty:
+	void set_empty(size_t i);
+	//add a box with corner (x,y) and size (w,h); returns its index:
+	size_t add(float x, float y, float w, float h);
+
+	//write the mask of boxes overlapping the box with corner (x,y) and size (w,h) to mask[0 .. mask_words()):
+	// (uses SSE when the compiler targets it, otherwise the scalar version)
+	void overlaps(float x, float y, float w, float h, uint32_t *mask) const;
+	//same, always one box at a time (for platforms without SIMD, and for comparison):
+	void overlaps_scalar(float x, float y, float w, float h, uint32_t *mask) const;
+
+	//convenience version for sets of at most 32 boxes:
+	uint32_t overlap_mask(float x, float y, float w, float h) const;
+
+	//name of the kernel 'overlaps' uses ("sse" or "scalar"):
+	static char const *kernel();
+
+	//edges of each box, padded with empty boxes to a multiple of Lanes:
+	std::vector< float > min_x, min_y, max_x, max_y;
+	size_t count = 0;
+};
@@ -0,0 +1,49 @@
+#include "Atlas.hpp"
+
+#include "read_write_chunk.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+#include <cstdio>
+
+Atlas::Atlas(std::string const &filename) {
+	std::ifstream file(filename, std::ios::binary);
+	if (!file) {
+		throw std::runtime_error("Failed to open atlas '" + filename + "'");
+	}
+
+	std::vector< char > strings;
+	read_chunk(file, "str0", &strings);
+
+	std::vector< Entry > entries;
+	read_chunk(file, "atl0", &entries);
+
+	for (auto const &entry : entries) {
+		if (!(entry.name_begin <= entry.name_end && entry.name_end <= strings.size())) {
+			throw std::runtime_error("atlas entry has out-of-range name begin/end");
+		}
+		std::string name(strings.data() + entry.name_begin, strings.data() + entry.name_end);
+		Sprite sprite;
+		sprite.tex = entry.tex;
+		sprite.tex_size = entry.tex_size;
+		sprite.size = glm::uvec2(entry.width, entry.height);
+		bool inserted = sprites.insert(std::make_pair(name, sprite)).second;
+		if (!inserted) {
+			std::cerr << "WARNING: sprite name '" + name + "' in atlas '" + filename + "' collides with existing sprite." << std::endl;
+		}
+	}
+
+	if (file.peek() != EOF) {
+		std::cerr << "WARNING: trailing data in atlas '" << filename << "'" << std::endl;
+	}
+}
+
+Atlas::Sprite const &Atlas::lookup(std::string const &name) const {
+	auto f = sprites.find(name);
+	if (f == sprites.end()) {
+		throw std::runtime_error("Looking up sprite '" + name + "' that doesn't exist.");
+	}
+	return f->second;
+}
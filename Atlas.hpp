@@ -0,0 +1,46 @@
+#pragma once
+
+/*
+ * An "Atlas" is a set of named sprites packed into one texture by atlas_packer
+ * (see atlas_packer.cpp), so every sprite can be drawn with the same texture
+ * bound -- and so in the same batch.
+ *
+ * The atlas file holds a "str0" chunk of sprite names and an "atl0" chunk of
+ * Atlas::Entry (name range + texture rectangle); the image is a separate PNG.
+ * Sprites can be looked up by name using Atlas::lookup().
+ *
+ * It doesn't depend on OpenGL (whoever draws uploads the PNG).
+ */
+
+#include <glm/glm.hpp>
+
+#include <map>
+#include <string>
+#include <cstdint>
+
+struct Atlas {
+	//construct from a file written by atlas_packer:
+	// note: will throw if file fails to read.
+	Atlas(std::string const &filename);
+
+	struct Sprite {
+		glm::vec2 tex = glm::vec2(0.0f); //upper left corner, in texture coordinates
+		glm::vec2 tex_size = glm::vec2(0.0f); //in texture coordinates
+		glm::uvec2 size = glm::uvec2(0); //in pixels (as drawn at 1:1)
+	};
+
+	//look up a particular sprite by name:
+	// note: will throw if sprite not found.
+	Sprite const &lookup(std::string const &name) const;
+
+	std::map< std::string, Sprite > sprites;
+
+	//on-disk format of "atl0":
+	struct Entry {
+		uint32_t name_begin, name_end; //range of "str0"
+		glm::vec2 tex; //upper left corner, in texture coordinates (image rows stored top-down)
+		glm::vec2 tex_size;
+		uint16_t width, height; //in pixels
+	};
+	static_assert(sizeof(Entry) == 28, "Atlas entry should be packed");
+};
@@ -45,6 +45,9 @@ typedef int ssize_t;
 //Also, some help and examples for getaddrinfo from: https://beej.us/guide/bgnet/html/multi/syscalls.html
 
 
+char const *const ConnectionBackend = "select";
+size_t const ConnectionMaxSockets = FD_SETSIZE;
+
 void Connection::close() {
 	if (socket != InvalidSocket) {
 		::closesocket(socket);
@@ -113,6 +116,7 @@ void poll_connections(
 			#endif
 				connections.emplace_back();
 				connections.back().socket = got;
+				connections.back().last_recv = connections.back().last_send = std::chrono::steady_clock::now();
 				std::cerr << "[" << where << "] client connected on " << connections.back().socket << "." << std::endl; //INFO
 				if (on_event) on_event(&connections.back(), Connection::OnOpen);
 			}
@@ -143,6 +147,8 @@ void poll_connections(
 			if (on_event) on_event(&c, Connection::OnClose);
 		} else { //ret > 0
 			c.recv_buffer.insert(c.recv_buffer.end(), buffer, buffer + ret);
+			c.last_recv = std::chrono::steady_clock::now();
+			c.bytes_received += uint64_t(ret);
 			if (on_event) on_event(&c, Connection::OnRecv);
 		}
 	}
@@ -170,6 +176,8 @@ void poll_connections(
 			if (on_event) on_event(&c, Connection::OnClose);
 		} else { //ret seems reasonable
 			c.send_buffer.erase(c.send_buffer.begin(), c.send_buffer.begin() + ret);
+			c.last_send = std::chrono::steady_clock::now();
+			c.bytes_sent += uint64_t(ret);
 		}
 	}
 
@@ -270,13 +278,42 @@ Server::Server(std::string const &port) {
 }
 
 void Server::poll(std::function< void(Connection *, Connection::Event event) > const &on_event, double timeout) {
-	poll_connections("Server::poll", connections, on_event, timeout, listen_socket);
+	if (idle_timeout > 0.0) {
+		poll_connections("Server::poll", connections, [&](Connection *c, Connection::Event evt){
+			//start watching new connections for idle timeouts:
+			if (evt == Connection::OnOpen) {
+				c->timeout_slot = timeouts.schedule(c, idle_timeout, c->last_recv);
+			}
+			if (on_event) on_event(c, evt);
+		}, timeout, listen_socket);
+	} else {
+		poll_connections("Server::poll", connections, on_event, timeout, listen_socket);
+	}
+
+	//close connections that have gone quiet for too long:
+	// (only connections in slots that have come due are checked; ones that have seen activity since being scheduled are rescheduled)
+	if (idle_timeout > 0.0) {
+		auto now = std::chrono::steady_clock::now();
+		timeouts.advance(now, [&](Connection *c){
+			c->timeout_slot = -1U;
+			if (c->socket == InvalidSocket) return;
+			double idle = std::chrono::duration< double >(now - c->last_recv).count();
+			if (idle < idle_timeout) {
+				c->timeout_slot = timeouts.schedule(c, idle_timeout - idle, now);
+			} else {
+				std::cerr << "[Server::poll] connection on " << c->socket << " idle for " << idle << " seconds, disconnecting." << std::endl;
+				c->close();
+				if (on_event) on_event(c, Connection::OnClose);
+			}
+		});
+	}
 
 	//reap closed clients:
 	for (auto connection = connections.begin(); connection != connections.end(); /*later*/) {
 		auto old = connection;
 		++connection;
 		if (old->socket == InvalidSocket) {
+			timeouts.cancel(&*old, old->timeout_slot);
 			connections.erase(old);
 		}
 	}
@@ -338,6 +375,7 @@ Client::Client(std::string const &host, std::string const &port) : connections(1
 			std::cout << "success!" << std::endl;
 
 			connection.socket = s;
+			connection.last_recv = connection.last_send = std::chrono::steady_clock::now();
 			break;
 		}
 
@@ -352,5 +390,15 @@ Client::Client(std::string const &host, std::string const &port) : connections(1
 
 void Client::poll(std::function< void(Connection *, Connection::Event event) > const &on_event, double timeout) {
 	poll_connections("Client::poll", connections, on_event, timeout, InvalidSocket);
+
+	//only one connection, so no need for anything fancier than a direct check:
+	if (idle_timeout > 0.0 && connection) {
+		double idle = std::chrono::duration< double >(std::chrono::steady_clock::now() - connection.last_recv).count();
+		if (idle >= idle_timeout) {
+			std::cerr << "[Client::poll] server idle for " << idle << " seconds, disconnecting." << std::endl;
+			connection.close();
+			if (on_event) on_event(&connection, Connection::OnClose);
+		}
+	}
 }
 
@@ -60,10 +60,18 @@ int main(int argc, char **argv) {
 #endif
 //--------- ---------------------------------- ---------
 
+#include "TimerWheel.hpp"
+
 #include <vector>
 #include <list>
 #include <string>
 #include <functional>
+#include <chrono>
+
+//Which mechanism poll() uses to wait on sockets, and how many sockets it can watch at once:
+// (select() is limited to FD_SETSIZE sockets -- on POSIX, to socket numbers below FD_SETSIZE)
+extern char const *const ConnectionBackend;
+extern size_t const ConnectionMaxSockets;
 
 //Thin wrapper around a (polling-based) TCP socket connection:
 struct Connection {
@@ -91,6 +99,16 @@ struct Connection {
 	//internals:
 	Socket socket = InvalidSocket;
 
+	//time of the last successful recv() on this connection (used for idle timeouts):
+	std::chrono::steady_clock::time_point last_recv = std::chrono::steady_clock::now();
+	//time of the last successful send() on this connection (useful for deciding when to send a heartbeat):
+	std::chrono::steady_clock::time_point last_send = std::chrono::steady_clock::now();
+	//running totals of bytes moved over this connection:
+	uint64_t bytes_sent = 0;
+	uint64_t bytes_received = 0;
+	//slot this connection occupies in its Server's timeout wheel (-1U if none):
+	uint32_t timeout_slot = -1U;
+
 	enum Event {
 		OnOpen,
 		OnRecv,
@@ -109,6 +127,14 @@ struct Server {
 
 	std::list< Connection > connections;
 	Socket listen_socket = InvalidSocket;
+
+	//connections that haven't received anything for idle_timeout seconds are
+	// closed (with an OnClose event) during poll(); 0.0 disables the check:
+	double idle_timeout = 0.0;
+
+	//internals:
+	//timeouts are checked from a timer wheel, so a poll() only looks at connections that might have expired:
+	TimerWheel< Connection * > timeouts;
 };
 
 
@@ -123,4 +149,8 @@ struct Client {
 
 	std::list< Connection > connections; //will only ever contain exactly one connection
 	Connection &connection; //reference to the only connection in the connections list
+
+	//if the server hasn't sent anything for idle_timeout seconds, the connection
+	// is closed (with an OnClose event) during poll(); 0.0 disables the check:
+	double idle_timeout = 0.0;
 };
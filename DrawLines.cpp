@@ -1,6 +1,7 @@
 #include "DrawLines.hpp"
 #include "PathFont.hpp"
 #include "ColorProgram.hpp"
+#include "StreamBuffer.hpp"
 
 #include "gl_errors.hpp"
 
@@ -9,14 +10,14 @@
 //All DrawLines instances share a vertex array object and vertex buffer, initialized at load time:
 
 //n.b. declared static so they don't conflict with similarly named global variables elsewhere:
-static GLuint vertex_buffer = 0;
+static StreamBuffer vertex_buffer; //(orphaned on each upload, like SpriteBatch's)
 static GLuint vertex_buffer_for_color_program = 0;
 
 static Load< void > setup_buffers(LoadTagDefault, [](){
 	//you may recognize this init code from DrawSprites.cpp:
 
 	{ //set up vertex buffer:
-		glGenBuffers(1, &vertex_buffer);
+		vertex_buffer.alloc();
 		//for now, buffer will be un-filled.
 	}
 
@@ -28,7 +29,7 @@ static Load< void > setup_buffers(LoadTagDefault, [](){
 		glBindVertexArray(vertex_buffer_for_color_program);
 
 		//set vertex_buffer as the source of glVertexAttribPointer() commands:
-		glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+		glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer.buffer);
 
 		//set up the vertex array object to describe arrays of PongMode::Vertex:
 		glVertexAttribPointer(
@@ -138,9 +139,7 @@ DrawLines::~DrawLines() {
 	//based on DrawSprites.cpp :
 
 	//upload vertices to vertex_buffer:
-	glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer); //set vertex_buffer as current
-	glBufferData(GL_ARRAY_BUFFER, attribs.size() * sizeof(attribs[0]), attribs.data(), GL_STREAM_DRAW); //upload attribs array
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	vertex_buffer.upload(attribs.data(), attribs.size() * sizeof(attribs[0]));
 
 	//set color_program as current program:
 	glUseProgram(color_program->program);
@@ -0,0 +1,68 @@
+#pragma once
+
+/*
+ * Fixed is a 16.16 fixed-point number: a 32-bit integer counting 1/65536ths.
+ *
+ * Everything is integer arithmetic, so a sequence of operations gives the same
+ * bits on every compiler and platform (unlike float, where the result can
+ * depend on contraction, excess precision, and library functions). Range is
+ * about +/-32767 with a resolution of about 0.000015.
+ *
+ * Products and quotients are computed in 64 bits and rounded toward negative
+ * infinity; overflow past the 32-bit range is not checked.
+ */
+
+#include <cstdint>
+
+struct Fixed {
+	static constexpr int32_t One = 65536;
+
+	int32_t raw = 0;
+
+	constexpr Fixed() = default;
+	constexpr Fixed(int32_t whole) : raw(whole * One) { }
+
+	static constexpr Fixed from_raw(int32_t raw_) {
+		Fixed ret;
+		ret.raw = raw_;
+		return ret;
+	}
+	//num / den (den > 0), rounded to nearest (for building constants without going through float):
+	static constexpr Fixed ratio(int64_t num, int64_t den) {
+		return from_raw(int32_t(floor_div64(2 * num * One + den, 2 * den)));
+	}
+
+	//for display / the wire only; never feed the result back into the simulation:
+	float to_float() const { return float(raw) / float(One); }
+
+	//floor(this / d) and ceil(this / d) for a whole-number divisor d > 0:
+	constexpr int32_t floor_div(int32_t d) const { return int32_t(floor_div64(raw, int64_t(d) * One)); }
+	constexpr int32_t ceil_div(int32_t d) const { return -int32_t(floor_div64(-int64_t(raw), int64_t(d) * One)); }
+
+	constexpr Fixed operator-() const { return from_raw(-raw); }
+	constexpr Fixed operator+(Fixed o) const { return from_raw(raw + o.raw); }
+	constexpr Fixed operator-(Fixed o) const { return from_raw(raw - o.raw); }
+	constexpr Fixed operator*(Fixed o) const { return from_raw(int32_t(floor_div64(int64_t(raw) * o.raw, One))); }
+	constexpr Fixed operator/(Fixed o) const { return from_raw(int32_t(floor_div64(int64_t(raw) * One, o.raw))); }
+	Fixed &operator+=(Fixed o) { raw += o.raw; return *this; }
+	Fixed &operator-=(Fixed o) { raw -= o.raw; return *this; }
+	Fixed &operator*=(Fixed o) { return *this = *this * o; }
+
+	constexpr bool operator==(Fixed o) const { return raw == o.raw; }
+	constexpr bool operator!=(Fixed o) const { return raw != o.raw; }
+	constexpr bool operator<(Fixed o) const { return raw < o.raw; }
+	constexpr bool operator>(Fixed o) const { return raw > o.raw; }
+	constexpr bool operator<=(Fixed o) const { return raw <= o.raw; }
+	constexpr bool operator>=(Fixed o) const { return raw >= o.raw; }
+
+	//integer division rounding toward negative infinity (C++ '/' rounds toward zero):
+	static constexpr int64_t floor_div64(int64_t a, int64_t b) {
+		int64_t q = a / b;
+		return (q * b != a && ((a < 0) != (b < 0))) ? q - 1 : q;
+	}
+};
+static_assert(sizeof(Fixed) == 4, "Fixed is one int32_t");
+static_assert(Fixed::ratio(1, 2).raw == 32768, "ratio");
+static_assert(Fixed::ratio(-1, 3).raw == -21845, "ratio rounds to nearest");
+static_assert((Fixed(-3) * Fixed::ratio(1, 2)).raw == -98304, "multiply");
+static_assert(Fixed::ratio(-1, 2).floor_div(1) == -1 && Fixed::ratio(-1, 2).ceil_div(1) == 0, "floor/ceil");
@@ -0,0 +1,226 @@
+#include "Game.hpp"
+
+#include "data_path.hpp"
+#include "hex_dump.hpp"
+#include "map_generator.hpp"
+#include "SnapshotRate.hpp"
+
+#include <ctime>
+#include <cstdlib>
+#include <chrono>
+#include <cmath>
+#include <cassert>
+#include <iostream>
+#include <algorithm>
+
+Game::Game(Client &client_, bool use_net_thread) : client(client_) {
+
+	srand((unsigned int) time(NULL));
+
+	client.idle_timeout = ServerTimeout;
+	if (use_net_thread) {
+		net_thread.reset(new NetThread(client, HeartbeatInterval));
+	}
+
+	// load level data
+	level = Level(data_path("level_data"));
+	for (uint32_t x = 0; x < level.width; x++) {
+		for (uint32_t y = 0; y < level.height; y++) {
+			if (level.tile(x, y) == TILE_SPAWN) {
+				spawns.emplace_back(glm::vec2(x, y) * Level::TileSize);
+			}
+		}
+	}
+}
+
+Game::~Game() {
+}
+
+void Game::update(float elapsed) {
+	if (player != nullptr) {
+		//advance the simulation in fixed steps, carrying leftover time to the next frame:
+		sim_accumulator += elapsed;
+		uint32_t steps = 0;
+		while (sim_accumulator >= SIM_STEP && steps < MAX_SIM_STEPS) {
+			player_prev_pos = player->pos;
+			simulate();
+			sim_accumulator -= SIM_STEP;
+			steps += 1;
+		}
+		//if frames are very slow, drop the backlog rather than spiral into ever more steps per frame:
+		if (steps == MAX_SIM_STEPS) sim_accumulator = std::min(sim_accumulator, SIM_STEP);
+
+		//draw the player between the last two simulated states:
+		player_draw_pos = glm::mix(player_prev_pos, player->pos, sim_accumulator / SIM_STEP);
+
+		//queue data for sending to server:
+		//send a six-byte message of type 's':
+		short x_short = (short) whole(body.x);
+		short y_short = (short) whole(body.y);
+		unsigned char *cx = reinterpret_cast<unsigned char *>(&x_short);
+		unsigned char *cy = reinterpret_cast<unsigned char *>(&y_short);
+		uint8_t message[6] = {
+			uint8_t('s'),
+			uint8_t(cx[0]), uint8_t(cx[1]),
+			uint8_t(cy[0]), uint8_t(cy[1]),
+			uint8_t(uint8_t(player->airborne) << 2 | uint8_t(player->sliding_left) << 1 | uint8_t(player->sliding_right))
+		};
+		send_to_server(message, sizeof(message));
+	}
+
+	if (net_thread) {
+		//network traffic is handled on net_thread; just pick up whatever it has received since last frame:
+		if (net_thread->lost) {
+			throw std::runtime_error("Lost connection to server!");
+		}
+		if (net_thread->update()) {
+			NetThread::Latest const &latest = net_thread->current();
+			//apply every snapshot since the last frame (that the ring still holds), oldest first,
+			// so arrival gaps and position histories see each one at the time it actually arrived:
+			uint32_t first = applied_sequence + 1;
+			if (latest.sequence >= NetThread::Latest::RecentCount && first < latest.sequence - NetThread::Latest::RecentCount + 1) {
+				first = latest.sequence - NetThread::Latest::RecentCount + 1;
+			}
+			for (uint32_t s = first; s <= latest.sequence; ++s) {
+				apply_snapshot(latest.snapshot(s));
+			}
+			applied_sequence = latest.sequence;
+			//mirror the thread's estimates for the HUD:
+			server_clock.rtt = latest.rtt;
+			server_clock.jitter = latest.jitter;
+			server_clock.offset = latest.offset;
+		}
+		interpolate_others();
+		return;
+	}
+
+	{ //keep the connection alive even when there is nothing else to say (e.g., before the first update arrives):
+		Connection &c = client.connections.back();
+		server_clock.update(c);
+		float quiet = std::chrono::duration< float >(std::chrono::steady_clock::now() - c.last_send).count();
+		if (c.send_buffer.empty() && quiet >= HeartbeatInterval) {
+			c.send('h');
+		}
+	}
+
+	//send/receive data:
+	client.poll([this](Connection *c, Connection::Event event){
+		if (event == Connection::OnOpen) {
+			std::cout << "[" << c->socket << "] opened" << std::endl;
+		} else if (event == Connection::OnClose) {
+			std::cout << "[" << c->socket << "] closed (!)" << std::endl;
+			throw std::runtime_error("Lost connection to server!");
+		} else { assert(event == Connection::OnRecv);
+			//std::cout << "[" << c->socket << "] recv'd data. Current buffer:\n" << hex_dump(c->recv_buffer); std::cout.flush();
+			while (c->recv_buffer.size() >= 1) {
+				char type = c->recv_buffer[0];
+				if (type == 'q') { // ping from server
+					if (!NetClock::handle_ping(c)) break;
+				} else if (type == 'r') { // pong (answer to one of our pings)
+					if (!server_clock.handle_pong(c)) break;
+				} else if (type == 'a') { // game state
+					Snapshot snapshot;
+					if (!Snapshot::parse(c->recv_buffer, &snapshot)) break; //if whole message isn't here, can't process
+					snapshot.arrival = Snapshot::now();
+					apply_snapshot(snapshot);
+				} else {
+					throw std::runtime_error("Server sent unknown message type '" + std::to_string(type) + "'");
+				}
+			}
+		}
+	}, 0.0);
+
+	interpolate_others();
+}
+
+void Game::send_to_server(void const *data, size_t size) {
+	if (net_thread) net_thread->send_raw(data, size);
+	else client.connections.back().send_raw(data, size);
+}
+
+void Game::apply_snapshot(Snapshot const &snapshot) {
+	bool first_message = false; // whether this is our first update
+	if (player == nullptr) {
+		first_message = true;
+		player = &players[snapshot.color & 0x7];
+		player->color = snapshot.color & 0x7;
+	}
+
+	if (last_snapshot_arrival != 0.0) {
+		float gap = float(snapshot.arrival - last_snapshot_arrival);
+		snapshot_interval += 0.1f * (gap - snapshot_interval);
+	}
+	last_snapshot_arrival = snapshot.arrival;
+	snapshots_applied += 1;
+
+	bool existed[MAX_PLAYERS];
+	for (uint8_t i = 0; i < MAX_PLAYERS; i++) {
+		existed[i] = players[i].exists;
+		players[i].exists = false; // auto remove players we don't get updates on
+	}
+	for (uint8_t i = 0; i < snapshot.count; i++) {
+		Snapshot::Entry const &entry = snapshot.entries[i];
+
+		uint8_t color_state = entry.state;
+		uint8_t index = color_state & 0x7;
+		Player *p = &players[index];
+		if (!existed[index]) p->history = PositionHistory(); //don't interpolate from wherever a previous player was
+		p->color = index;
+		p->it = (color_state >> 7) & 1;
+		p->exists = true;
+
+		glm::vec2 pos = glm::vec2((float) entry.x, (float) entry.y);
+		if (player == p) {
+			if (first_message) random_spawn();
+		} else {
+			p->history.record(snapshot.arrival, pos.x, pos.y);
+			p->airborne = (color_state >> 6) & 1;
+			p->sliding_left = (color_state >> 5) & 1;
+			p->sliding_right = (color_state >> 4) & 1;
+		}
+	}
+}
+
+void Game::simulate() {
+	assert(player);
+
+	GamePhysics::Input input;
+	input.left = left.pressed;
+	input.right = right.pressed;
+	input.jump = up.pressed || space.pressed;
+
+	bool in_pit = GamePhysics::step(body, input, physics, level);
+
+	player->pos = glm::vec2(to_float(body.x), to_float(body.y));
+	player->vel = glm::vec2(to_float(body.vx), to_float(body.vy));
+	player->airborne = body.airborne;
+	player->sliding_left = body.sliding_left;
+	player->sliding_right = body.sliding_right;
+
+	if (in_pit) {
+		random_spawn();
+		char pit = 'p'; // tell server we fell into the pit
+		send_to_server(&pit, 1);
+	}
+}
+
+void Game::interpolate_others() {
+	double view_time = Snapshot::now() - SnapshotRate::InterpIntervals * snapshot_interval;
+	for (uint8_t i = 0; i < MAX_PLAYERS; i++) {
+		Player &p = players[i];
+		if (&p == player || !p.exists) continue;
+		p.history.at(view_time, &p.pos.x, &p.pos.y);
+	}
+}
+
+void Game::random_spawn() {
+	// pick player spawn
+	glm::uvec2 spawn = spawns[rand() % spawns.size()];
+	body = GamePhysics::Body();
+	body.x = int32_t(spawn.x);
+	body.y = int32_t(spawn.y);
+	player->pos = glm::vec2(spawn);
+	player->vel = glm::vec2(0.0f, 0.0f);
+	//teleport, so don't interpolate from the old position:
+	player_prev_pos = player_draw_pos = player->pos;
+}
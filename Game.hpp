@@ -0,0 +1,106 @@
+#pragma once
+
+/*
+ * Game is the client's side of the game without any drawing: the connection
+ * to the server, the level, everyone's players, and the local player's
+ * simulation.
+ *
+ * It doesn't depend on OpenGL or SDL, so it can run without a window
+ * (see headless-client.cpp); PlayMode wraps one and draws it.
+ */
+
+#include "Connection.hpp"
+#include "Level.hpp"
+#include "NetClock.hpp"
+#include "NetThread.hpp"
+#include "Snapshot.hpp"
+#include "PositionHistory.hpp"
+#include "Physics.hpp"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <string>
+#include <memory>
+
+struct Game {
+	//if use_net_thread is set, the connection is serviced on a background thread rather than in update():
+	Game(Client &client, bool use_net_thread = false);
+	~Game();
+
+	//simulate the local player and exchange messages with the server (throws if the connection is lost):
+	void update(float elapsed);
+
+	//input tracking:
+	struct Button {
+		uint8_t pressed = 0;
+	} left, right, up, space;
+
+	//last message from server:
+	std::string server_message;
+
+	//connection to server:
+	Client &client;
+
+	//send a heartbeat if nothing else has been sent for this long (seconds):
+	static constexpr float HeartbeatInterval = 0.5f;
+	//give up on the server if nothing has been received for this long (seconds):
+	static constexpr float ServerTimeout = 5.0f;
+
+	//background thread servicing 'client' (if enabled):
+	std::unique_ptr< NetThread > net_thread;
+
+	//queue a message for the server (via net_thread, if running):
+	void send_to_server(void const *data, size_t size);
+	//update players from the server's game state:
+	void apply_snapshot(Snapshot const &snapshot);
+	//place other players where they were a little while ago, interpolating between snapshots:
+	// (the server varies how often it sends snapshots, so this keeps motion smooth at low rates)
+	void interpolate_others();
+	double last_snapshot_arrival = 0.0; //seconds (Snapshot::now() time base)
+	float snapshot_interval = 1.0f / 60.0f; //smoothed time between snapshots (seconds)
+	uint32_t snapshots_applied = 0; //game state updates received
+	uint32_t applied_sequence = 0; //with net_thread: NetThread::Latest::sequence of the last snapshot applied
+
+	//round-trip time / clock offset estimates for the server connection:
+	NetClock server_clock;
+
+	Level level; //tile grid, used for collision
+	std::vector<glm::uvec2> spawns;
+
+	struct Player {
+		glm::vec2 pos;
+		glm::vec2 size;
+		glm::vec2 vel = glm::vec2(0.0f, 0.0f);
+		uint8_t color = 0; // equal to index in players[]
+		bool it = false;
+		bool exists = false;
+		bool airborne = false;
+		bool sliding_left = false;
+		bool sliding_right = false;
+		PositionHistory history; //recent positions from the server (for interpolating other players)
+		Player() {
+			pos = glm::vec2(0.0f, 0.0f);
+			size = glm::vec2(20.0f, 20.0f);
+		}
+	};
+
+	static const uint8_t MAX_PLAYERS = 8;
+
+	Player players[MAX_PLAYERS];
+	Player *player = nullptr; //the local player (once the server has assigned one)
+
+	//the simulation runs in fixed steps, independent of frame rate:
+	static constexpr uint32_t SIM_RATE = 120; //steps per second
+	const float SIM_STEP = 1.0f / SIM_RATE;
+	const uint32_t MAX_SIM_STEPS = 8; //per frame; beyond this, time is dropped
+	float sim_accumulator = 0.0f; //time not yet simulated
+	GamePhysics::Params physics{SIM_RATE}; //movement tuning, per step
+	GamePhysics::Body body; //the local player's simulation state ('player' mirrors it for drawing + sending)
+	glm::vec2 player_prev_pos = glm::vec2(0.0f); //player position before the most recent step
+	glm::vec2 player_draw_pos = glm::vec2(0.0f); //player position interpolated for drawing
+	//advance the local player by one SIM_STEP:
+	void simulate();
+
+	void random_spawn();
+};
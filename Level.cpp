@@ -0,0 +1,64 @@
+#include "Level.hpp"
+
+#include "read_write_chunk.hpp"
+#include "map_generator.hpp"
+
+#include <fstream>
+#include <cmath>
+#include <algorithm>
+
+static Level load_level(std::string const &filename) {
+	std::ifstream file(filename, std::ios::binary);
+	if (!file) {
+		throw std::runtime_error("Failed to open level file '" + filename + "'.");
+	}
+
+	std::vector< uint32_t > width_chunk;
+	std::vector< uint8_t > tiles;
+	read_chunk(file, "widt", &width_chunk);
+	read_chunk(file, "lev0", &tiles);
+
+	if (width_chunk.size() != 1 || width_chunk[0] == 0 || tiles.size() % width_chunk[0] != 0) {
+		throw std::runtime_error("Level file '" + filename + "' has a bad width.");
+	}
+
+	return Level(tiles, width_chunk[0]);
+}
+
+Level::Level(std::string const &filename) : Level(load_level(filename)) {
+}
+
+Level::Level(std::vector< uint8_t > const &tiles_, uint32_t width_) : width(width_), tiles(tiles_) {
+	if (width == 0 || tiles.size() % width != 0) {
+		throw std::runtime_error("Level has a bad width.");
+	}
+	height = uint32_t(tiles.size()) / width;
+
+	flags.assign(tiles.size(), 0);
+	for (size_t i = 0; i < tiles.size(); ++i) {
+		flags[i] = flags_for_tile(tiles[i]);
+	}
+}
+
+uint8_t Level::flags_for_tile(uint8_t tile) {
+	if (tile == TILE_WALL || tile == TILE_INNER) return Solid;
+	if (tile == TILE_OUTOFBOUNDS) return Pit;
+	return 0;
+}
+
+Level::TileRange Level::tiles_overlapped(float x, float y, float w, float h) {
+	TileRange r;
+	r.x0 = int32_t(std::floor(x / TileSize));
+	r.y0 = int32_t(std::floor(y / TileSize));
+	r.x1 = int32_t(std::ceil((x + w) / TileSize)) - 1;
+	r.y1 = int32_t(std::ceil((y + h) / TileSize)) - 1;
+	return r;
+}
+
+uint8_t Level::overlap(float x, float y, float w, float h) const {
+	uint8_t ret = 0;
+	for_each_overlap(x, y, w, h, 0xff, [&](int32_t tx, int32_t ty){
+		ret |= flag(tx, ty);
+	});
+	return ret;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+/*
+ * Level holds the tile grid written by map_generator (the 'widt' + 'lev0'
+ * chunks of 'level_data') in a form that is cheap to query for collision.
+ *
+ * It doesn't depend on OpenGL, so both the client and the server can use it.
+ */
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+struct Level {
+	Level() = default;
+	Level(std::string const &filename); //load from a 'level_data' file (throws on failure)
+	//build from a grid of TILE_* codes:
+	Level(std::vector< uint8_t > const &tiles, uint32_t width);
+
+	//per-tile collision flags:
+	enum : uint8_t {
+		Solid = 1, //walls + inner tiles
+		Pit = 2, //out-of-bounds tiles
+	};
+
+	static constexpr float TileSize = 20.0f;
+
+	uint32_t width = 0; //in tiles
+	uint32_t height = 0; //in tiles
+	std::vector< uint8_t > tiles; //TILE_* codes, row-major, width * height entries
+	std::vector< uint8_t > flags; //collision flags, same layout as 'tiles'
+
+	//collision flags for a TILE_* code:
+	static uint8_t flags_for_tile(uint8_t tile);
+
+	//TILE_* code at tile (x,y) (TILE_NONE outside the level):
+	uint8_t tile(int32_t x, int32_t y) const {
+		if (x < 0 || y < 0 || uint32_t(x) >= width || uint32_t(y) >= height) return 0;
+		return tiles[y * width + x];
+	}
+	//collision flags at tile (x,y) (tiles outside the level count as Solid):
+	uint8_t flag(int32_t x, int32_t y) const {
+		if (x < 0 || y < 0 || uint32_t(x) >= width || uint32_t(y) >= height) return Solid;
+		return flags[y * width + x];
+	}
+
+	//range of tiles overlapped by the (open) box with corner (x,y) and size (w,h):
+	// (boxes that exactly touch a tile edge don't count as overlapping it)
+	struct TileRange {
+		int32_t x0, y0, x1, y1; //inclusive
+	};
+	static TileRange tiles_overlapped(float x, float y, float w, float h);
+
+	//OR of the flags of all tiles overlapped by the box; costs O(1) per tile touched:
+	uint8_t overlap(float x, float y, float w, float h) const;
+
+	//call fn(tx, ty) for each tile overlapped by the box that has any of the flags in 'mask':
+	template< typename F >
+	void for_each_overlap(float x, float y, float w, float h, uint8_t mask, F const &fn) const {
+		TileRange r = tiles_overlapped(x, y, w, h);
+		for (int32_t ty = r.y0; ty <= r.y1; ++ty) {
+			for (int32_t tx = r.x0; tx <= r.x1; ++tx) {
+				if (flag(tx, ty) & mask) fn(tx, ty);
+			}
+		}
+	}
+};
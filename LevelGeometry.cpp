@@ -0,0 +1,236 @@
+#include "LevelGeometry.hpp"
+
+#include "map_generator.hpp"
+
+#include <cstdlib>
+#include <cassert>
+#include <cmath>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define APPEND_QUADS_SSE 1
+#include <emmintrin.h>
+#endif
+
+void append_sprite(std::vector< SpriteVertex > &vertices, glm::vec2 pos, glm::vec2 size, glm::vec2 tilepos, glm::vec2 tilesize, glm::u8vec4 color, float rotation, glm::vec2 tileset_size) {
+	if (rotation != 0.0f) {
+		append_sprite_rotated(vertices, pos, size, tilepos, tilesize, color, rotation, tileset_size);
+		return;
+	}
+	SpriteQuad quad;
+	quad.pos = pos;
+	quad.size = size;
+	quad.tex = glm::vec2(tilepos.x * Level::TileSize / tileset_size.x, tilepos.y * Level::TileSize / tileset_size.y);
+	quad.tex_size = glm::vec2(tilesize.x * Level::TileSize / tileset_size.x, tilesize.y * Level::TileSize / tileset_size.y);
+	quad.color = color;
+	append_quad(vertices, quad);
+}
+
+void append_sprite_rotated(std::vector< SpriteVertex > &vertices, glm::vec2 pos, glm::vec2 size, glm::vec2 tilepos, glm::vec2 tilesize, glm::u8vec4 color, float rotation, glm::vec2 tileset_size) {
+	glm::vec2 tex = glm::vec2(tilepos.x * Level::TileSize / tileset_size.x, tilepos.y * Level::TileSize / tileset_size.y);
+	glm::vec2 tex_size = glm::vec2(tilesize.x * Level::TileSize / tileset_size.x, tilesize.y * Level::TileSize / tileset_size.y);
+
+	//rotate corners around the rectangle's center:
+	// (same direction as the rotation matrix this replaced: +rotation turns clockwise on screen, where y points down)
+	float c = std::cos(rotation);
+	float s = std::sin(rotation);
+	glm::vec2 center = pos + 0.5f * size;
+	auto corner = [&](float x, float y) {
+		x -= center.x;
+		y -= center.y;
+		return glm::vec3(center.x + c * x + s * y, center.y - s * x + c * y, 0.0f);
+	};
+
+	// bot_left will be top left on screen after clip transformation
+	glm::vec3 bot_left = corner(pos.x, pos.y);
+	glm::vec3 bot_right = corner(pos.x + size.x, pos.y);
+	glm::vec3 top_right = corner(pos.x + size.x, pos.y + size.y);
+	glm::vec3 top_left = corner(pos.x, pos.y + size.y);
+
+	//draw rectangle as two CCW-oriented triangles:
+	vertices.emplace_back(bot_left, color, glm::vec2(tex.x, tex.y));
+	vertices.emplace_back(bot_right, color, glm::vec2(tex.x + tex_size.x, tex.y));
+	vertices.emplace_back(top_right, color, glm::vec2(tex.x + tex_size.x, tex.y + tex_size.y));
+
+	vertices.emplace_back(bot_left, color, glm::vec2(tex.x, tex.y));
+	vertices.emplace_back(top_right, color, glm::vec2(tex.x + tex_size.x, tex.y + tex_size.y));
+	vertices.emplace_back(top_left, color, glm::vec2(tex.x, tex.y + tex_size.y));
+}
+
+void append_quad(std::vector< SpriteVertex > &vertices, SpriteQuad const &quad) {
+	float x0 = quad.pos.x, x1 = quad.pos.x + quad.size.x;
+	float y0 = quad.pos.y, y1 = quad.pos.y + quad.size.y;
+	float u0 = quad.tex.x, u1 = quad.tex.x + quad.tex_size.x;
+	float v0 = quad.tex.y, v1 = quad.tex.y + quad.tex_size.y;
+
+	//same corner order as append_sprite_rotated:
+	vertices.emplace_back(glm::vec3(x0, y0, 0.0f), quad.color, glm::vec2(u0, v0));
+	vertices.emplace_back(glm::vec3(x1, y0, 0.0f), quad.color, glm::vec2(u1, v0));
+	vertices.emplace_back(glm::vec3(x1, y1, 0.0f), quad.color, glm::vec2(u1, v1));
+
+	vertices.emplace_back(glm::vec3(x0, y0, 0.0f), quad.color, glm::vec2(u0, v0));
+	vertices.emplace_back(glm::vec3(x1, y1, 0.0f), quad.color, glm::vec2(u1, v1));
+	vertices.emplace_back(glm::vec3(x0, y1, 0.0f), quad.color, glm::vec2(u0, v1));
+}
+
+void append_quads_scalar(std::vector< SpriteVertex > &vertices, SpriteQuad const *quads, size_t count) {
+	vertices.reserve(vertices.size() + 6 * count);
+	for (size_t i = 0; i < count; ++i) {
+		append_quad(vertices, quads[i]);
+	}
+}
+
+#ifdef APPEND_QUADS_SSE
+void append_quads(std::vector< SpriteVertex > &vertices, SpriteQuad const *quads, size_t count) {
+	size_t base = vertices.size();
+	vertices.resize(base + 6 * count);
+	SpriteVertex *out = vertices.data() + base;
+
+	//lanes are (x, y, u, v); corners mix the low and high ends per lane:
+	__m128 const x_hi = _mm_castsi128_ps(_mm_set_epi32(0, -1, 0, -1)); //(x1, y0, u1, v0) = bottom right
+	__m128 const y_hi = _mm_castsi128_ps(_mm_set_epi32(-1, 0, -1, 0)); //(x0, y1, u0, v1) = top left
+
+	auto store = [](SpriteVertex &v, __m128 corner, glm::u8vec4 color) {
+		_mm_storel_pi(reinterpret_cast< __m64 * >(&v.Position), corner);
+		v.Position.z = 0.0f;
+		v.Color = color;
+		_mm_storeh_pi(reinterpret_cast< __m64 * >(&v.TexCoord), corner);
+	};
+
+	for (size_t i = 0; i < count; ++i, out += 6) {
+		SpriteQuad const &quad = quads[i];
+		__m128 lo = _mm_loadu_ps(&quad.pos.x); //pos, tex
+		__m128 hi = _mm_add_ps(lo, _mm_loadu_ps(&quad.size.x)); //pos + size, tex + tex_size
+		__m128 br = _mm_or_ps(_mm_and_ps(x_hi, hi), _mm_andnot_ps(x_hi, lo));
+		__m128 tl = _mm_or_ps(_mm_and_ps(y_hi, hi), _mm_andnot_ps(y_hi, lo));
+
+		store(out[0], lo, quad.color);
+		store(out[1], br, quad.color);
+		store(out[2], hi, quad.color);
+		store(out[3], lo, quad.color);
+		store(out[4], hi, quad.color);
+		store(out[5], tl, quad.color);
+	}
+}
+
+char const *append_quads_kernel() {
+	return "sse";
+}
+#else
+void append_quads(std::vector< SpriteVertex > &vertices, SpriteQuad const *quads, size_t count) {
+	append_quads_scalar(vertices, quads, count);
+}
+
+char const *append_quads_kernel() {
+	return "scalar";
+}
+#endif
+
+LevelGeometry::LevelGeometry(Level const &level) : width(level.width), height(level.height) {
+	chunks_x = (level.width + ChunkSize - 1) / ChunkSize;
+	chunks_y = (level.height + ChunkSize - 1) / ChunkSize;
+	chunk_walls.reserve(chunks_x * chunks_y + 1);
+
+	for (uint32_t cy = 0; cy < chunks_y; ++cy) {
+		for (uint32_t cx = 0; cx < chunks_x; ++cx) {
+			chunk_walls.emplace_back(uint32_t(walls.size()));
+			for (uint32_t y = cy * ChunkSize; y < std::min(level.height, (cy + 1) * ChunkSize); ++y) {
+				for (uint32_t x = cx * ChunkSize; x < std::min(level.width, (cx + 1) * ChunkSize); ++x) {
+					if (level.tile(x, y) == TILE_WALL) {
+						walls.emplace_back(glm::vec2(x, y) * Level::TileSize, glm::vec2(Level::TileSize, Level::TileSize));
+					}
+					if (level.tile(x, y) == TILE_INNER) {
+						walls.emplace_back(glm::vec2(x, y) * Level::TileSize, glm::vec2(Level::TileSize, Level::TileSize));
+						Wall *w = &walls.back();
+						w->tile_variant = (rand() % 3) + 1;
+					}
+				}
+			}
+		}
+	}
+	chunk_walls.emplace_back(uint32_t(walls.size()));
+}
+
+void LevelGeometry::build(std::vector< SpriteVertex > &vertices, glm::vec2 tileset_size) const {
+	glm::u8vec4 white = glm::u8vec4(255, 255, 255, 255);
+	glm::vec2 tile_tex = glm::vec2(float(Level::TileSize)) / tileset_size; //one tileset tile, in texture coordinates
+
+	std::vector< SpriteQuad > quads;
+	quads.reserve(BackgroundQuads + walls.size());
+	auto add = [&](glm::vec2 pos, glm::vec2 size, glm::vec2 tilepos) {
+		SpriteQuad quad;
+		quad.pos = pos;
+		quad.size = size;
+		quad.tex = tilepos * tile_tex;
+		quad.tex_size = tile_tex;
+		quad.color = white;
+		quads.emplace_back(quad);
+	};
+
+	//background:
+	glm::vec2 pos1 = glm::vec2(1.0f, 1.0f) * Level::TileSize;
+	glm::vec2 size1 = glm::vec2(51.0f, 50.0f) * Level::TileSize;
+
+	glm::vec2 pos2 = glm::vec2(22.0f, 51.0f) * Level::TileSize;
+	glm::vec2 size2 = glm::vec2(9.0f, 39.0f) * Level::TileSize;
+
+	add(pos1, size1, glm::vec2(2.0f, 0.0f));
+	add(pos2, size2, glm::vec2(2.0f, 0.0f));
+	assert(quads.size() == BackgroundQuads);
+
+	//walls:
+	for (auto const &wall : walls) {
+		add(wall.pos, wall.size, glm::vec2(0.0f, wall.tile_variant));
+	}
+
+	append_quads(vertices, quads.data(), quads.size());
+}
+
+void LevelGeometry::visible(glm::vec2 min, glm::vec2 max, std::vector< int > &first, std::vector< int > &count) const {
+	first.clear();
+	count.clear();
+
+	//add a range of sprites, extending the previous range if they are adjacent:
+	auto add = [&](uint32_t begin, uint32_t end) {
+		if (begin == end) return;
+		if (!first.empty() && uint32_t(first.back() + count.back()) == 6 * begin) {
+			count.back() += int(6 * (end - begin));
+		} else {
+			first.emplace_back(int(6 * begin));
+			count.emplace_back(int(6 * (end - begin)));
+		}
+	};
+
+	//the background is a couple of big quads; the rasterizer clips them cheaply:
+	add(0, BackgroundQuads);
+
+	if (chunks_x == 0 || chunks_y == 0 || !(min.x <= max.x && min.y <= max.y)) return;
+
+	//chunk range overlapping [min, max] (clamped to the level):
+	float chunk_pixels = float(ChunkSize * Level::TileSize);
+	auto chunk_index = [chunk_pixels](float at, uint32_t chunks) {
+		float c = std::floor(at / chunk_pixels);
+		return uint32_t(std::max(0.0f, std::min(float(chunks - 1), c)));
+	};
+	if (max.x < 0.0f || max.y < 0.0f || min.x >= chunks_x * chunk_pixels || min.y >= chunks_y * chunk_pixels) return;
+	uint32_t cx0 = chunk_index(min.x, chunks_x), cx1 = chunk_index(max.x, chunks_x);
+	uint32_t cy0 = chunk_index(min.y, chunks_y), cy1 = chunk_index(max.y, chunks_y);
+
+	//chunks are row-major, so each row of visible chunks is one run of walls:
+	for (uint32_t cy = cy0; cy <= cy1; ++cy) {
+		uint32_t begin = chunk_walls[cy * chunks_x + cx0];
+		uint32_t end = chunk_walls[cy * chunks_x + cx1 + 1];
+		add(BackgroundQuads + begin, BackgroundQuads + end);
+	}
+}
+
+void LevelGeometry::build_cells(std::vector< glm::u8vec2 > &cells) const {
+	cells.assign(width * height, glm::u8vec2(NoCell, NoCell));
+	for (auto const &wall : walls) {
+		uint32_t x = uint32_t(wall.pos.x / Level::TileSize);
+		uint32_t y = uint32_t(wall.pos.y / Level::TileSize);
+		assert(x < width && y < height);
+		//same tileset tile build() uses:
+		cells[y * width + x] = glm::u8vec2(0, uint8_t(wall.tile_variant));
+	}
+}
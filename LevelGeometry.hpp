@@ -0,0 +1,101 @@
+#pragma once
+
+/*
+ * Sprite vertices for the game's tileset, and the level's (static) share of them.
+ *
+ * Level geometry never moves -- only the camera does -- so PlayMode builds it
+ * once into a GL_STATIC_DRAW buffer and applies the camera in OBJECT_TO_CLIP;
+ * just players and text are rebuilt each frame. Walls are stored chunk by chunk,
+ * so drawing just what the camera sees takes a few contiguous ranges of that
+ * buffer (see visible()).
+ *
+ * It doesn't depend on OpenGL, so vertex generation can be benchmarked headless
+ * (see bench-sprites.cpp).
+ */
+
+#include "Level.hpp"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+//vertex layout used with ColorTextureProgram:
+struct SpriteVertex {
+	SpriteVertex() { } //uninitialized (so storage can be resize()'d and filled in place)
+	SpriteVertex(glm::vec3 const &Position_, glm::u8vec4 const &Color_, glm::vec2 const &TexCoord_) :
+		Position(Position_), Color(Color_), TexCoord(TexCoord_) { }
+	glm::vec3 Position;
+	glm::u8vec4 Color;
+	glm::vec2 TexCoord;
+};
+static_assert(sizeof(SpriteVertex) == 4*3 + 1*4 + 4*2, "SpriteVertex should be packed");
+
+//append a (possibly rotated) rectangle textured with part of the tileset as two CCW triangles:
+// pos, size are in pixels; tilepos, tilesize are in tileset tiles (Level::TileSize pixels each)
+// (rotation == 0 takes the append_quad() path; anything else, append_sprite_rotated())
+void append_sprite(std::vector< SpriteVertex > &vertices, glm::vec2 pos, glm::vec2 size, glm::vec2 tilepos, glm::vec2 tilesize, glm::u8vec4 color, float rotation, glm::vec2 tileset_size);
+
+//same, rotated by 'rotation' radians around the rectangle's center:
+void append_sprite_rotated(std::vector< SpriteVertex > &vertices, glm::vec2 pos, glm::vec2 size, glm::vec2 tilepos, glm::vec2 tilesize, glm::u8vec4 color, float rotation, glm::vec2 tileset_size);
+
+//an axis-aligned rectangle with texture coordinates (not tiles) already worked out:
+struct SpriteQuad {
+	glm::vec2 pos; //lower corner (pixels)
+	glm::vec2 tex; //texture coordinate at pos
+	glm::vec2 size; //(pixels)
+	glm::vec2 tex_size; //texture coordinate change across size
+	glm::u8vec4 color;
+};
+static_assert(offsetof(SpriteQuad, tex) == offsetof(SpriteQuad, pos) + 8 && offsetof(SpriteQuad, tex_size) == offsetof(SpriteQuad, size) + 8, "SpriteQuad corners are loaded as (x, y, u, v)");
+
+//append one axis-aligned quad (six vertices; only additions, no transforms):
+void append_quad(std::vector< SpriteVertex > &vertices, SpriteQuad const &quad);
+
+//append many axis-aligned quads at once:
+// (uses SSE when the compiler targets it, otherwise the scalar version)
+void append_quads(std::vector< SpriteVertex > &vertices, SpriteQuad const *quads, size_t count);
+//same, always one append_quad() at a time (for platforms without SIMD, and for comparison):
+void append_quads_scalar(std::vector< SpriteVertex > &vertices, SpriteQuad const *quads, size_t count);
+//name of the kernel 'append_quads' uses ("sse" or "scalar"):
+char const *append_quads_kernel();
+
+struct LevelGeometry {
+	//pick wall sprites for each wall + inner tile of 'level' (inner tiles get a random variant):
+	LevelGeometry(Level const &level);
+
+	struct Wall {
+		glm::vec2 pos;
+		glm::vec2 size;
+		unsigned int tile_variant = 0;
+		Wall(glm::vec2 _pos, glm::vec2 _size): pos(_pos), size(_size) { }
+	};
+	std::vector< Wall > walls; //grouped by chunk
+
+	uint32_t width = 0; //level size, in tiles
+	uint32_t height = 0;
+
+	//walls are grouped into square chunks of ChunkSize x ChunkSize tiles, stored row-major:
+	static constexpr uint32_t ChunkSize = 8;
+	uint32_t chunks_x = 0;
+	uint32_t chunks_y = 0;
+	std::vector< uint32_t > chunk_walls; //chunk c holds walls[chunk_walls[c], chunk_walls[c+1])
+
+	//background quads come first in build()'s output:
+	static constexpr uint32_t BackgroundQuads = 2;
+
+	//append the background and wall sprites, in level (pixel) coordinates:
+	void build(std::vector< SpriteVertex > &vertices, glm::vec2 tileset_size) const;
+
+	//replace first / count with the vertex ranges of build()'s output needed to draw everything
+	// overlapping the rectangle [min, max] (level pixels) -- the background plus about one range
+	// per row of visible chunks (suitable for glMultiDrawArrays):
+	void visible(glm::vec2 min, glm::vec2 max, std::vector< int > &first, std::vector< int > &count) const;
+
+	//the walls as a grid of tileset cells -- for each tile (row-major, width * height entries),
+	// the (column, row) of the tileset tile drawn there, or (NoCell, NoCell) for none:
+	// (this is what TilemapLayer draws from)
+	static constexpr uint8_t NoCell = 0xff;
+	void build_cells(std::vector< glm::u8vec2 > &cells) const;
+};
@@ -17,7 +17,13 @@ struct LitColorTextureProgram {
 	GLuint Color_vec4 = -1U;
 	GLuint TexCoord_vec2 = -1U;
 
+	//Uniform blocks:
+	//Object - OBJECT_TO_CLIP, OBJECT_TO_LIGHT, NORMAL_TO_LIGHT (see Scene::ObjectBlock)
+	//Material - TINT, EMISSION (see Scene::Material)
+
 	//Uniform (per-invocation variable) locations:
+	//the matrices are in the Object block, so these are -1 (kept so code that copies them into a
+	// Pipeline still works; Scene::draw only uses them when the pipeline has no Object block):
 	GLuint OBJECT_TO_CLIP_mat4 = -1U;
 	GLuint OBJECT_TO_LIGHT_mat4x3 = -1U;
 	GLuint NORMAL_TO_LIGHT_mat3 = -1U;
@@ -0,0 +1,91 @@
+#include "NetClock.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+
+static void send_u64(Connection &c, uint64_t val) {
+	for (uint32_t i = 0; i < 8; ++i) {
+		c.send(uint8_t((val >> (8 * i)) & 0xff));
+	}
+}
+
+static uint64_t u64_from_buf(std::vector< char > const &buffer, size_t start) {
+	uint64_t val = 0;
+	for (uint32_t i = 0; i < 8; ++i) {
+		val |= uint64_t(uint8_t(buffer[start + i])) << (8 * i);
+	}
+	return val;
+}
+
+static uint64_t to_us(std::chrono::steady_clock::time_point const &t) {
+	return uint64_t(std::chrono::duration_cast< std::chrono::microseconds >(t.time_since_epoch()).count());
+}
+
+uint64_t NetClock::now_us() {
+	return to_us(std::chrono::steady_clock::now());
+}
+
+void NetClock::update(Connection &connection) {
+	uint64_t now = now_us();
+	if (last_ping_us != 0 && double(now - last_ping_us) < ping_interval * 1e6) return;
+	last_ping_us = now;
+
+	connection.send('q');
+	send_u64(connection, now);
+}
+
+bool NetClock::handle_ping(Connection *c) {
+	if (c->recv_buffer.size() < 1 + 8) return false;
+	uint64_t t0 = u64_from_buf(c->recv_buffer, 1);
+	//the ping arrived (at the latest) with the most recent recv():
+	uint64_t t1 = to_us(c->last_recv);
+
+	c->send('r');
+	send_u64(*c, t0);
+	send_u64(*c, t1);
+	send_u64(*c, now_us());
+
+	c->recv_buffer.erase(c->recv_buffer.begin(), c->recv_buffer.begin() + 1 + 8);
+	return true;
+}
+
+bool NetClock::handle_pong(Connection *c) {
+	if (c->recv_buffer.size() < 1 + 3 * 8) return false;
+	uint64_t t0 = u64_from_buf(c->recv_buffer, 1);
+	uint64_t t1 = u64_from_buf(c->recv_buffer, 1 + 8);
+	uint64_t t2 = u64_from_buf(c->recv_buffer, 1 + 16);
+	add_sample(t0, t1, t2, to_us(c->last_recv));
+
+	c->recv_buffer.erase(c->recv_buffer.begin(), c->recv_buffer.begin() + 1 + 3 * 8);
+	return true;
+}
+
+void NetClock::add_sample(uint64_t t0, uint64_t t1, uint64_t t2, uint64_t t3) {
+	//usual NTP formulas (differences taken as signed so clocks needn't share an epoch):
+	double local = double(int64_t(t3 - t0)) * 1e-6;
+	double remote = double(int64_t(t2 - t1)) * 1e-6;
+	float delay = float(std::max(0.0, local - remote));
+	double sample_offset = 0.5 * (double(int64_t(t1 - t0)) + double(int64_t(t2 - t3))) * 1e-6;
+
+	if (samples == 0) {
+		rtt = delay;
+		jitter = 0.5f * delay;
+	} else {
+		//smoothing as per TCP's RTT estimator (RFC 6298):
+		jitter += 0.25f * (std::abs(delay - rtt) - jitter);
+		rtt += 0.125f * (delay - rtt);
+	}
+	samples += 1;
+
+	window[window_next].delay = delay;
+	window[window_next].offset = sample_offset;
+	window_next = (window_next + 1) % Window;
+
+	uint32_t count = std::min(samples, Window);
+	Sample const *best = &window[0];
+	for (uint32_t i = 1; i < count; ++i) {
+		if (window[i].delay < best->delay) best = &window[i];
+	}
+	offset = best->offset;
+}
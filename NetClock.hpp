@@ -0,0 +1,57 @@
+#pragma once
+
+/*
+ * NetClock estimates round-trip time, jitter, and clock offset to the peer
+ * on the other end of a Connection, using NTP-style ping/pong exchanges:
+ *
+ *  'q' + t0            ping: t0 = sender's clock when the ping was sent
+ *  'r' + t0 + t1 + t2  pong: t1 = responder's clock when the ping arrived,
+ *                            t2 = responder's clock when the pong was sent
+ *
+ * (all timestamps are 8-byte little-endian microseconds on the sender's
+ *  steady clock; t3 is the pinger's clock when the pong arrives)
+ *
+ * Either end may ping; both ends should answer pings with handle_ping().
+ */
+
+#include "Connection.hpp"
+
+#include <cstdint>
+
+struct NetClock {
+	//how often update() sends a ping (seconds):
+	float ping_interval = 1.0f;
+
+	//estimates (seconds):
+	float rtt = 0.0f; //smoothed round-trip time
+	float jitter = 0.0f; //smoothed deviation of round-trip samples from 'rtt'
+	double offset = 0.0; //peer clock minus local clock, from the lowest-delay recent sample
+	uint32_t samples = 0; //number of completed exchanges
+
+	//send a ping over 'connection' if ping_interval has passed since the last one:
+	void update(Connection &connection);
+
+	//if the front of connection->recv_buffer is a complete 'q' message, answer it and consume it:
+	// (returns false if the message is not yet complete)
+	static bool handle_ping(Connection *connection);
+	//if the front of connection->recv_buffer is a complete 'r' message, fold it into the estimates and consume it:
+	// (returns false if the message is not yet complete)
+	bool handle_pong(Connection *connection);
+
+	//fold in one completed exchange (times in microseconds):
+	void add_sample(uint64_t t0, uint64_t t1, uint64_t t2, uint64_t t3);
+
+	//current time on the local steady clock, in microseconds:
+	static uint64_t now_us();
+
+	//internals:
+	uint64_t last_ping_us = 0;
+	//NTP keeps a short window of samples and trusts the offset from the one with the least delay,
+	// since it's the one least distorted by queuing:
+	static constexpr uint32_t Window = 8;
+	struct Sample {
+		float delay = 0.0f;
+		double offset = 0.0;
+	} window[Window];
+	uint32_t window_next = 0;
+};
@@ -0,0 +1,74 @@
+#include "NetThread.hpp"
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <cassert>
+
+NetThread::NetThread(Client &client_, float heartbeat_interval_) : client(client_), heartbeat_interval(heartbeat_interval_) {
+	thread = std::thread(&NetThread::run, this);
+}
+
+NetThread::~NetThread() {
+	quit = true;
+	if (thread.joinable()) thread.join();
+}
+
+void NetThread::send_raw(void const *data, size_t size) {
+	std::lock_guard< std::mutex > lock(outbox_mutex);
+	outbox.insert(outbox.end(), reinterpret_cast< char const * >(data), reinterpret_cast< char const * >(data) + size);
+}
+
+void NetThread::run() {
+	Connection &connection = client.connection;
+	while (!quit && !lost) {
+		{ //move anything queued by the render thread into the connection:
+			std::lock_guard< std::mutex > lock(outbox_mutex);
+			if (!outbox.empty()) {
+				connection.send_buffer.insert(connection.send_buffer.end(), outbox.begin(), outbox.end());
+				outbox.clear();
+			}
+		}
+
+		clock.update(connection);
+		float quiet = std::chrono::duration< float >(std::chrono::steady_clock::now() - connection.last_send).count();
+		if (connection.send_buffer.empty() && quiet >= heartbeat_interval) {
+			connection.send('h');
+		}
+
+		try {
+			client.poll([this](Connection *c, Connection::Event event){
+				if (event == Connection::OnClose) {
+					std::cout << "[" << c->socket << "] closed (!)" << std::endl;
+					lost = true;
+				} else if (event == Connection::OnRecv) {
+					while (!c->recv_buffer.empty()) {
+						char type = c->recv_buffer[0];
+						if (type == 'q') { // ping from server
+							if (!NetClock::handle_ping(c)) break;
+						} else if (type == 'r') { // pong (answer to one of our pings)
+							if (!clock.handle_pong(c)) break;
+						} else if (type == 'a') {
+							Snapshot &snapshot = received.recent[received.sequence % Latest::RecentCount];
+							if (!Snapshot::parse(c->recv_buffer, &snapshot)) break;
+							snapshot.arrival = Snapshot::now();
+							received.sequence += 1;
+							received.rtt = clock.rtt;
+							received.jitter = clock.jitter;
+							received.offset = clock.offset;
+							//(back() is a couple of publishes out of date, so it gets the whole ring:)
+							latest.back() = received;
+							latest.publish();
+						} else {
+							throw std::runtime_error("Server sent unknown message type '" + std::to_string(type) + "'");
+						}
+					}
+				}
+			}, PollTimeout);
+		} catch (std::exception const &e) {
+			std::cerr << "[NetThread] " << e.what() << std::endl;
+			connection.close();
+			lost = true;
+		}
+	}
+}
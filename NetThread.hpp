@@ -0,0 +1,76 @@
+#pragma once
+
+/*
+ * NetThread services a Client's connection on a background thread, so that
+ * network traffic isn't tied to the render loop's frame rate:
+ *
+ *  - incoming 'a' messages are parsed into Snapshots (stamped with their
+ *    arrival time) and handed over through a TripleBuffer, along with the
+ *    few before them, so the render thread can apply every snapshot that
+ *    arrived since its last frame, in order, without blocking;
+ *  - pings and heartbeats are answered/sent from the thread;
+ *  - messages queued with send() are written out on the thread's next pass,
+ *    which is at most PollTimeout after they are queued.
+ *
+ * Once a NetThread is running, only it may touch the Client.
+ */
+
+#include "Connection.hpp"
+#include "NetClock.hpp"
+#include "Snapshot.hpp"
+#include "TripleBuffer.hpp"
+
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <vector>
+
+struct NetThread {
+	NetThread(Client &client, float heartbeat_interval);
+	~NetThread(); //stops and joins the thread
+
+	//queue data to be sent to the server:
+	template< typename T >
+	void send(T const &t) {
+		send_raw(&t, sizeof(T));
+	}
+	void send_raw(void const *data, size_t size);
+
+	//what the render thread gets to see:
+	struct Latest {
+		//the most recent snapshots -- snapshot number s (counting from 1) is in recent[(s - 1) % RecentCount]:
+		// (a frame that takes longer than RecentCount snapshots loses the oldest ones)
+		static constexpr uint32_t RecentCount = 16;
+		Snapshot recent[RecentCount];
+		uint32_t sequence = 0; //number of the newest snapshot in 'recent' (0 = none yet)
+		Snapshot const &snapshot(uint32_t s) const { return recent[(s - 1) % RecentCount]; }
+		//connection stats as of when the snapshot arrived:
+		float rtt = 0.0f;
+		float jitter = 0.0f;
+		double offset = 0.0;
+	};
+	//swap in the newest data from the network thread (never blocks); returns true if it changed:
+	bool update() { return latest.update(); }
+	Latest const &current() const { return latest.front(); }
+
+	//set (and never cleared) if the connection closed:
+	std::atomic< bool > lost{false};
+
+	//how long the thread waits in select() per pass (seconds):
+	static constexpr double PollTimeout = 0.001;
+
+	//internals:
+	void run();
+
+	Client &client;
+	float heartbeat_interval;
+	NetClock clock; //only touched by the network thread
+	TripleBuffer< Latest > latest;
+	Latest received; //only touched by the network thread; copied to latest.back() to publish
+
+	std::mutex outbox_mutex;
+	std::vector< char > outbox; //bytes queued by send(), guarded by outbox_mutex
+
+	std::atomic< bool > quit{false};
+	std::thread thread;
+};
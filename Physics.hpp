@@ -0,0 +1,219 @@
+#pragma once
+
+/*
+ * Physics is the player movement step, written once for any scalar type S:
+ *  - Physics< float > is the usual build.
+ *  - Physics< Fixed > (16.16 fixed point) gives bit-identical trajectories on
+ *    every compiler and platform, so two machines running the same inputs from
+ *    the same state end up in exactly the same place (lockstep, rollback, or
+ *    server-side re-simulation can then check inputs instead of shipping state).
+ *
+ * GamePhysics picks one for the game; building with PHYSICS_FIXED_POINT
+ * defined (e.g., 'jam -sFIXED_PHYSICS=1') selects the fixed-point version.
+ *
+ * It doesn't depend on OpenGL, so both the client and the server can use it.
+ */
+
+#include "Fixed.hpp"
+#include "Level.hpp"
+
+#include <cmath>
+#include <cstdint>
+
+//operations the movement step needs that differ between float and Fixed:
+inline float to_float(float v) { return v; }
+inline float to_float(Fixed v) { return v.to_float(); }
+//v rounded toward zero to a whole number (what goes on the wire):
+inline int32_t whole(float v) { return int32_t(v); }
+inline int32_t whole(Fixed v) { return v.raw / Fixed::One; }
+//floor(v / d) and ceil(v / d) for a whole-number divisor d > 0:
+inline int32_t floor_div(float v, int32_t d) { return int32_t(std::floor(v / float(d))); }
+inline int32_t floor_div(Fixed v, int32_t d) { return v.floor_div(d); }
+inline int32_t ceil_div(float v, int32_t d) { return int32_t(std::ceil(v / float(d))); }
+inline int32_t ceil_div(Fixed v, int32_t d) { return v.ceil_div(d); }
+//num / den as an S:
+template< typename S > S ratio(int64_t num, int64_t den);
+template< > inline float ratio< float >(int64_t num, int64_t den) { return float(double(num) / double(den)); }
+template< > inline Fixed ratio< Fixed >(int64_t num, int64_t den) { return Fixed::ratio(num, den); }
+
+template< typename S >
+struct Physics {
+	//movement tuning (pixels, seconds):
+	static constexpr int32_t X_DECEL = 50000;
+	static constexpr int32_t X_ACCEL = 200000;
+	static constexpr int32_t MAX_X_SPEED = 400;
+	static constexpr int32_t MIN_X_SPEED = 50;
+	static constexpr int32_t MAX_SLIDE_SPEED = 200;
+	static constexpr int32_t JUMP_IMPULSE = 700;
+	static constexpr int32_t WALL_JUMP_Y_IMPULSE = 700;
+	static constexpr int32_t WALL_JUMP_X_IMPULSE = 500;
+	static constexpr int32_t GRAVITY = 1666;
+	//the acceleration constants above were tuned with per-frame (elapsed * elapsed) updates at 60fps,
+	// so velocity changes are scaled by that frame time to keep the same feel at any step size:
+	static constexpr int32_t TUNED_FRAME_RATE = 60;
+
+	static constexpr int32_t TileSize = 20;
+	static_assert(float(TileSize) == Level::TileSize, "tiles are a whole number of pixels");
+
+	//the constants above, converted for one step of a simulation running at 'rate' steps per second:
+	// (per-step velocity changes are precomputed so fixed-point values stay well inside their range)
+	struct Params {
+		Params(uint32_t rate) :
+			dt(ratio< S >(1, rate)),
+			accel(ratio< S >(X_ACCEL, int64_t(TUNED_FRAME_RATE) * rate)),
+			decel(ratio< S >(X_DECEL, int64_t(TUNED_FRAME_RATE) * rate)),
+			gravity(ratio< S >(GRAVITY, rate)),
+			max_x_speed(MAX_X_SPEED), min_x_speed(MIN_X_SPEED), max_slide_speed(MAX_SLIDE_SPEED),
+			jump_impulse(JUMP_IMPULSE), wall_jump_y_impulse(WALL_JUMP_Y_IMPULSE), wall_jump_x_impulse(WALL_JUMP_X_IMPULSE) { }
+		S dt; //seconds per step
+		S accel, decel, gravity; //velocity change per step
+		S max_x_speed, min_x_speed, max_slide_speed;
+		S jump_impulse, wall_jump_y_impulse, wall_jump_x_impulse;
+	};
+
+	struct Input {
+		bool left = false;
+		bool right = false;
+		bool jump = false;
+	};
+
+	struct Body {
+		S x = S(0), y = S(0); //upper left corner
+		S w = S(TileSize), h = S(TileSize);
+		S vx = S(0), vy = S(0);
+		bool airborne = false;
+		bool sliding_left = false;
+		bool sliding_right = false;
+		bool can_jump = false;
+	};
+
+	//advance 'body' by one step; returns true if it fell into (or passed through) a pit:
+	static bool step(Body &body, Input const &input, Params const &params, Level const &level) {
+		if (input.left) body.vx -= params.accel;
+		if (input.right) body.vx += params.accel;
+
+		if (body.vx > params.max_x_speed) body.vx = params.max_x_speed;
+		if (body.vx < -params.max_x_speed) body.vx = -params.max_x_speed;
+
+		if (!input.left && !input.right) {
+			if ((body.vx < params.min_x_speed) && (body.vx > -params.min_x_speed)) {
+				body.vx = S(0);
+			} else if (body.vx > S(0)) {
+				body.vx -= params.decel;
+			} else {
+				body.vx += params.decel;
+			}
+		}
+
+		if (input.jump) {
+			if (body.can_jump) {
+				body.vy = -params.jump_impulse;
+				body.can_jump = false;
+			}
+			if (body.sliding_left) {
+				body.vy = -params.wall_jump_y_impulse;
+				body.vx = params.wall_jump_x_impulse;
+				body.sliding_left = false;
+			}
+			if (body.sliding_right) {
+				body.vy = -params.wall_jump_y_impulse;
+				body.vx = -params.wall_jump_x_impulse;
+				body.sliding_right = false;
+			}
+		}
+		body.vy += params.gravity;
+		if ((body.sliding_right || body.sliding_left) && body.vy > params.max_slide_speed) body.vy = params.max_slide_speed;
+
+		body.airborne = true;
+		body.sliding_left = false;
+		body.sliding_right = false;
+		body.can_jump = false;
+
+		//move along each axis in turn, stopping at the first wall in the way
+		// (swept, so even a long step can't carry the player through a wall):
+		uint8_t passed = 0; //flags of every tile the body passed over
+
+		S dx = body.vx * params.dt;
+		bool hit_x = false;
+		S x = sweep(level, body.x, body.w, dx, body.y, body.h, false, &hit_x);
+		passed |= swept_flags(level, body.x, body.w, x - body.x, body.y, body.h, false);
+		body.x = x;
+		if (hit_x) {
+			if (body.vx > S(0) && body.vy > S(0)) body.sliding_right = true;
+			if (body.vx < S(0) && body.vy > S(0)) body.sliding_left = true;
+			body.vx = S(0);
+		}
+
+		S dy = body.vy * params.dt;
+		bool hit_y = false;
+		S y = sweep(level, body.y, body.h, dy, body.x, body.w, true, &hit_y);
+		passed |= swept_flags(level, body.y, body.h, y - body.y, body.x, body.w, true);
+		body.y = y;
+		if (hit_y) {
+			if (body.vy > S(0)) {
+				body.can_jump = true;
+				body.airborne = false;
+			}
+			body.vy = S(0);
+		}
+
+		return (passed & Level::Pit) != 0;
+	}
+
+	//flags of the tile at (a, b), where a is along the motion and b is across it:
+	static uint8_t flag(Level const &level, int32_t a, int32_t b, bool along_y) {
+		return along_y ? level.flag(b, a) : level.flag(a, b);
+	}
+
+	//move the interval [a, a+size) by d along one axis (x, or y if along_y), where the box spans
+	// [b, b+b_size) across it; stops against the first Solid tile face, setting *hit
+	// (tiles the box already overlaps are ignored, and touching counts as a hit):
+	static S sweep(Level const &level, S a, S size, S d, S b, S b_size, bool along_y, bool *hit) {
+		*hit = false;
+		int32_t b0 = floor_div(b, TileSize);
+		int32_t b1 = ceil_div(b + b_size, TileSize) - 1;
+		auto blocked = [&](int32_t c) {
+			for (int32_t i = b0; i <= b1; ++i) {
+				if (flag(level, c, i, along_y) & Level::Solid) return true;
+			}
+			return false;
+		};
+		if (d > S(0)) {
+			for (int32_t c = ceil_div(a + size, TileSize), c1 = ceil_div(a + size + d, TileSize) - 1; c <= c1; ++c) {
+				if (blocked(c)) {
+					*hit = true;
+					return S(c * TileSize) - size;
+				}
+			}
+		} else if (d < S(0)) {
+			for (int32_t c = floor_div(a, TileSize) - 1, c1 = floor_div(a + d, TileSize); c >= c1; --c) {
+				if (blocked(c)) {
+					*hit = true;
+					return S((c + 1) * TileSize);
+				}
+			}
+		}
+		return a + d;
+	}
+
+	//flags of all tiles overlapped (open intervals, as in Level::overlap) by the box moving by d along one axis:
+	static uint8_t swept_flags(Level const &level, S a, S size, S d, S b, S b_size, bool along_y) {
+		S lo = (d < S(0) ? a + d : a);
+		S hi = (d > S(0) ? a + size + d : a + size);
+		int32_t b0 = floor_div(b, TileSize);
+		int32_t b1 = ceil_div(b + b_size, TileSize) - 1;
+		uint8_t ret = 0;
+		for (int32_t c = floor_div(lo, TileSize), c1 = ceil_div(hi, TileSize) - 1; c <= c1; ++c) {
+			for (int32_t i = b0; i <= b1; ++i) {
+				ret |= flag(level, c, i, along_y);
+			}
+		}
+		return ret;
+	}
+};
+
+#ifdef PHYSICS_FIXED_POINT
+typedef Physics< Fixed > GamePhysics;
+#else
+typedef Physics< float > GamePhysics;
+#endif
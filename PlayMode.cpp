@@ -3,81 +3,22 @@
 #include "DrawLines.hpp"
 #include "gl_errors.hpp"
 #include "data_path.hpp"
-#include "hex_dump.hpp"
 #include "load_save_png.hpp"
-#include "read_write_chunk.hpp"
 #include "map_generator.hpp"
 #include "ColorTextureProgram.hpp"
+#include "SpriteBatch.hpp"
 
 #include <glm/gtc/type_ptr.hpp>
 
 #include <cstring>
-#include <ctime>
+#include <cstdio>
 #include <random>
 #include <fstream>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
 
-PlayMode::PlayMode(Client &client_) : client(client_) {
-
-	srand((unsigned int) time(NULL));
-
-	//----- allocate OpenGL resources -----
-	{ //vertex buffer:
-		glGenBuffers(1, &vertex_buffer);
-		//for now, buffer will be un-filled.
-
-		GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
-	}
-
-	{ //vertex array mapping buffer for color_texture_program:
-		//ask OpenGL to fill vertex_buffer_for_color_texture_program with the name of an unused vertex array object:
-		glGenVertexArrays(1, &vertex_buffer_for_color_texture_program);
-
-		//set vertex_buffer_for_color_texture_program as the current vertex array object:
-		glBindVertexArray(vertex_buffer_for_color_texture_program);
-
-		//set vertex_buffer as the source of glVertexAttribPointer() commands:
-		glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
-
-		//set up the vertex array object to describe arrays of BoatMode::Vertex:
-		glVertexAttribPointer(
-			color_texture_program->Position_vec4, //attribute
-			3, //size
-			GL_FLOAT, //type
-			GL_FALSE, //normalized
-			sizeof(Vertex), //stride
-			(GLbyte *)0 + 0 //offset
-		);
-		glEnableVertexAttribArray(color_texture_program->Position_vec4);
-		//[Note that it is okay to bind a vec3 input to a vec4 attribute -- the w component will be filled with 1.0 automatically]
-
-		glVertexAttribPointer(
-			color_texture_program->Color_vec4, //attribute
-			4, //size
-			GL_UNSIGNED_BYTE, //type
-			GL_TRUE, //normalized
-			sizeof(Vertex), //stride
-			(GLbyte *)0 + 4*3 //offset
-		);
-		glEnableVertexAttribArray(color_texture_program->Color_vec4);
-
-		glVertexAttribPointer(
-			color_texture_program->TexCoord_vec2, //attribute
-			2, //size
-			GL_FLOAT, //type
-			GL_FALSE, //normalized
-			sizeof(Vertex), //stride
-			(GLbyte *)0 + 4*3 + 4*1 //offset
-		);
-		glEnableVertexAttribArray(color_texture_program->TexCoord_vec2);
-
-		//done referring to vertex_buffer, so unbind it:
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-		//done setting up vertex array object, so unbind it:
-		glBindVertexArray(0);
-
-		GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
-	}
+PlayMode::PlayMode(Client &client, bool use_net_thread) : game(client, use_net_thread), level_geometry(game.level), tilemap(level_geometry) {
 
 	// load tileset texture
 	{
@@ -100,44 +41,37 @@ PlayMode::PlayMode(Client &client_) : client(client_) {
 		GL_ERRORS();
 	}
 
-	// load level data
-	std::ifstream level_file;
-	level_file.open(data_path("level_data"));
-
-	std::vector<uint8_t> level;
-	std::vector<unsigned int> level_width_vec;
-
-	read_chunk(level_file, "widt", &level_width_vec);
-	read_chunk(level_file, "lev0", &level);
-
-	assert(level_width_vec.size() == 1);
-
-	unsigned int level_width = level_width_vec[0];
-	assert(level_width != 0);
-	unsigned int level_height = ((unsigned int) level.size()) / level_width;
-
-	// generate level objects
-	for (unsigned int x = 0; x < level_width; x++) {
-		for (unsigned int y = 0; y < level_height; y++) {
-			if (level[y * level_width + x] == TILE_WALL) {
-				walls.emplace_back(glm::vec2(x, y) * TILE_SIZE, glm::vec2(WALL_SIZE, WALL_SIZE));
-			}
-			if (level[y * level_width + x] == TILE_INNER) {
-				walls.emplace_back(glm::vec2(x, y) * TILE_SIZE, glm::vec2(WALL_SIZE, WALL_SIZE));
-				Wall *w = &walls.back();
-				w->tile_variant = (rand() % 3) + 1;
-			}
-			if (level[y * level_width + x] == TILE_SPAWN) {
-				spawns.emplace_back(glm::vec2(x, y) * TILE_SIZE);
-			}
-			if (level[y * level_width + x] == TILE_OUTOFBOUNDS) {
-				obwalls.emplace_back(glm::vec2(x, y) * TILE_SIZE, glm::vec2(WALL_SIZE, WALL_SIZE));
-			}
+	{ //frames of the tileset that players + text use:
+		sprite_instances.texture = tileset_tex;
+		for (uint32_t i = 0; i < 4; ++i) {
+			player_frames[i] = sprite_instances.frames.add_tiles(glm::vec2(1.0f, float(i)), glm::vec2(1.0f, 1.0f), tileset_size);
+		}
+		it_frame = sprite_instances.frames.add_tiles(glm::vec2(1.0f, 4.0f), glm::vec2(1.0f, 1.0f), tileset_size);
+		for (uint32_t j = 0; j < GlyphCount; ++j) {
+			glyph_frames[j] = sprite_instances.frames.add_tiles(glm::vec2(0.0f, 7.0f) + float(j) * glm::vec2(11.0f / 20.0f, 0.0f), glm::vec2(11.0f / 20.0f, 13.0f / 20.0f), tileset_size);
 		}
 	}
+
+	{ //level geometry never changes, so upload it once:
+		std::vector< Vertex > vertices;
+		level_geometry.build(vertices, tileset_size);
+
+		glGenBuffers(1, &level_buffer);
+		glBindBuffer(GL_ARRAY_BUFFER, level_buffer);
+		glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(vertices[0]), vertices.data(), GL_STATIC_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		level_buffer_for_color_texture_program = make_sprite_vertex_array(level_buffer);
+	}
 }
 
 PlayMode::~PlayMode() {
+	glDeleteVertexArrays(1, &level_buffer_for_color_texture_program);
+	level_buffer_for_color_texture_program = 0;
+	glDeleteBuffers(1, &level_buffer);
+	level_buffer = 0;
+	glDeleteTextures(1, &tileset_tex);
+	tileset_tex = 0;
 }
 
 bool PlayMode::handle_event(SDL_Event const &evt, glm::uvec2 const &window_size) {
@@ -146,30 +80,36 @@ bool PlayMode::handle_event(SDL_Event const &evt, glm::uvec2 const &window_size)
 		if (evt.key.repeat) {
 			//ignore repeats
 		} else if (evt.key.keysym.sym == SDLK_LEFT) {
-			left.pressed = true;
+			game.left.pressed = true;
 			return true;
 		} else if (evt.key.keysym.sym == SDLK_RIGHT) {
-			right.pressed = true;
+			game.right.pressed = true;
 			return true;
 		} else if (evt.key.keysym.sym == SDLK_UP) {
-			up.pressed = true;
+			game.up.pressed = true;
 			return true;
 		} else if (evt.key.keysym.sym == SDLK_SPACE) {
-			space.pressed = true;
+			game.space.pressed = true;
+			return true;
+		} else if (evt.key.keysym.sym == SDLK_F3) {
+			show_net_stats = !show_net_stats;
+			return true;
+		} else if (evt.key.keysym.sym == SDLK_F4) {
+			use_tilemap = !use_tilemap;
 			return true;
 		}
 	} else if (evt.type == SDL_KEYUP) {
 		if (evt.key.keysym.sym == SDLK_LEFT) {
-			left.pressed = false;
+			game.left.pressed = false;
 			return true;
 		} else if (evt.key.keysym.sym == SDLK_RIGHT) {
-			right.pressed = false;
+			game.right.pressed = false;
 			return true;
 		} else if (evt.key.keysym.sym == SDLK_UP) {
-			up.pressed = false;
+			game.up.pressed = false;
 			return true;
 		} else if (evt.key.keysym.sym == SDLK_SPACE) {
-			space.pressed = false;
+			game.space.pressed = false;
 			return true;
 		}
 	}
@@ -178,103 +118,10 @@ bool PlayMode::handle_event(SDL_Event const &evt, glm::uvec2 const &window_size)
 }
 
 void PlayMode::update(float elapsed) {
-	if (player != nullptr) {
-		//queue data for sending to server:
-		//send a seventeen-byte message of type 's':
-
-		client.connections.back().send('s');
-		short x_short = (short) player->pos.x;
-		short y_short = (short) player->pos.y;
-		unsigned char *cx = reinterpret_cast<unsigned char *>(&x_short);
-		client.connections.back().send(uint8_t(cx[0]));
-		client.connections.back().send(uint8_t(cx[1]));
-		unsigned char *cy = reinterpret_cast<unsigned char *>(&y_short);
-		client.connections.back().send(uint8_t(cy[0]));
-		client.connections.back().send(uint8_t(cy[1]));
-		client.connections.back().send(uint8_t(uint8_t(player->airborne) << 2 | uint8_t(player->sliding_left) << 1 | uint8_t(player->sliding_right)));
-
-		auto collision = [](Player p, Wall w) {
-			if (p.pos.x >= w.pos.x + w.size.x ||
-				p.pos.x <= w.pos.x - p.size.x ||
-				p.pos.y >= w.pos.y + w.size.y ||
-				p.pos.y <= w.pos.y - p.size.y) return false;
-			return true;
-		};
+	game.update(elapsed);
 
-		if (left.pressed) player->vel.x -= X_ACCEL * elapsed * elapsed;
-		if (right.pressed) player->vel.x += X_ACCEL * elapsed * elapsed;
-
-		if (player->vel.x > MAX_X_SPEED) player->vel.x = MAX_X_SPEED;
-		if (player->vel.x < -MAX_X_SPEED) player->vel.x = -MAX_X_SPEED;
-
-		if (!left.pressed && !right.pressed) {
-			if (glm::abs(player->vel.x) < MIN_X_SPEED) {
-				player->vel.x = 0;
-			} else {
-				player->vel.x -= glm::sign(player->vel.x) * X_DECEL * elapsed * elapsed;
-			}
-		}
-
-		if (up.pressed || space.pressed) {
-			if (can_jump) {
-				player->vel.y = -JUMP_IMPULSE;
-				can_jump = false;
-			}
-			if (player->sliding_left) {
-				player->vel.y = -WALL_JUMP_Y_IMPULSE;
-				player->vel.x = WALL_JUMP_X_IMPULSE;
-				player->sliding_left = false;
-			}
-			if (player->sliding_right) {
-				player->vel.y = -WALL_JUMP_Y_IMPULSE;
-				player->vel.x = -WALL_JUMP_X_IMPULSE;
-				player->sliding_right = false;
-			}
-		}
-		player->vel.y += GRAVITY * elapsed;
-		if ((player->sliding_right || player->sliding_left) && player->vel.y > MAX_SLIDE_SPEED) player->vel.y = MAX_SLIDE_SPEED;
-
-		player->airborne = true;
-		player->sliding_left = false;
-		player->sliding_right = false;
-		can_jump = false;
-		player->pos.x += player->vel.x * elapsed;
-		for (auto const &wall : walls) {
-			if (collision(*player, wall)) {
-				if (player->vel.x > 0) {
-					player->pos.x = wall.pos.x - player->size.x;
-					if (player->vel.y > 0) player->sliding_right = true;
-				}
-				if (player->vel.x < 0) {
-					player->pos.x = wall.pos.x + wall.size.x;
-					if (player->vel.y > 0) player->sliding_left = true;
-				}
-				player->vel.x = 0;
-			}
-		}
-
-		player->pos.y += player->vel.y * elapsed;
-		for (auto const &wall : walls) {
-			if (collision(*player, wall)) {
-				if (player->vel.y > 0) {
-					player->pos.y = wall.pos.y - player->size.y;
-					can_jump = true;
-					player->airborne = false;
-				}
-				if (player->vel.y < 0) player->pos.y = wall.pos.y + wall.size.y;
-				player->vel.y = 0;
-			}
-		}
-
-		for (auto const &wall : obwalls) {
-			if (collision(*player, wall)) {
-				random_spawn();
-				client.connections.back().send('p'); // tell server we fell into the pit
-				break;
-			}
-		}
-
-		camera = player->pos + 0.5f * player->size;
+	if (game.player != nullptr) {
+		camera = game.player_draw_pos + 0.5f * game.player->size;
 
 		// stop at level edges
 		camera.x = glm::max(WINDOW_SIZE.x * 0.5f, camera.x);
@@ -282,176 +129,62 @@ void PlayMode::update(float elapsed) {
 		camera.y = glm::max(WINDOW_SIZE.y * 0.5f, camera.y);
 		camera.y = glm::min(60.0f * TILE_SIZE - 0.5f * WINDOW_SIZE.y, camera.y);
 	}
+}
 
-	//send/receive data:
-	client.poll([this](Connection *c, Connection::Event event){
-		if (event == Connection::OnOpen) {
-			std::cout << "[" << c->socket << "] opened" << std::endl;
-		} else if (event == Connection::OnClose) {
-			std::cout << "[" << c->socket << "] closed (!)" << std::endl;
-			throw std::runtime_error("Lost connection to server!");
-		} else { assert(event == Connection::OnRecv);
-			//std::cout << "[" << c->socket << "] recv'd data. Current buffer:\n" << hex_dump(c->recv_buffer); std::cout.flush();
-			//expecting message(s) like 'm' + 3-byte length + length bytes of text:
-			while (c->recv_buffer.size() >= 2) {
-				//std::cout << "[" << c->socket << "] recv'd data. Current buffer:\n" << hex_dump(c->recv_buffer); std::cout.flush();
-				char type = c->recv_buffer[0];
-				if (type != 'a') {
-					throw std::runtime_error("Server sent unknown message type '" + std::to_string(type) + "'");
-				}
-				uint8_t size = c->recv_buffer[1];
-				if (c->recv_buffer.size() < 3 + 5 * size) break; //if whole message isn't here, can't process
-				
-				//whole message is here:
-				uint8_t color = c->recv_buffer[2];
-				bool first_message = false; // whether this is our first update
-				if (player == nullptr) {
-					first_message = true;
-					player = &players[color];
-					player->color = color;
-				}
-
-				for (uint8_t i = 0; i < MAX_PLAYERS; i++) players[i].exists = false; // auto remove players we don't get updates on
-				for (uint8_t i = 0; i < size; i++) {
-					unsigned int offset = 3 + i * 5;
-
-					uint8_t color_state = c->recv_buffer[offset];
-					uint8_t index = color_state & 0x7;
-					Player *p = &players[index];
-					p->color = index;
-					p->it = (color_state >> 7) & 1;
-					p->exists = true;
-
-					auto short_from_buf = [c](const std::vector<char> &buffer, const unsigned int &start_pos) {
-						unsigned char s1 = (unsigned char) c->recv_buffer[start_pos+1];
-						unsigned char s0 = (unsigned char) c->recv_buffer[start_pos];
-						unsigned int data = (s1 << 8 | s0);
-						return *reinterpret_cast<short *>(&data);
-					};
-
-					glm::vec2 pos = glm::vec2((float) short_from_buf(c->recv_buffer, offset + 1), (float) short_from_buf(c->recv_buffer, offset + 3));
-					if (player == p) {
-						if (first_message) random_spawn();
-					} else {
-						p->pos = pos;
-						p->airborne = (color_state >> 6) & 1;
-						p->sliding_left = (color_state >> 5) & 1;
-						p->sliding_right = (color_state >> 4) & 1;
-					}
-				}
-
-				//and consume this part of the buffer:
-				c->recv_buffer.erase(c->recv_buffer.begin(), c->recv_buffer.begin() + 3 + 5 * size);
-			}
+void PlayMode::drawPlayers() {
+	auto &instances = sprite_instances.instances;
+
+	for (uint8_t i = 0; i < Game::MAX_PLAYERS; i++) {
+		if (game.players[i].exists) {
+			uint16_t frame = player_frames[0];
+			if (game.players[i].sliding_right) frame = player_frames[1];
+			else if (game.players[i].sliding_left) frame = player_frames[2];
+			else if (game.players[i].airborne) frame = player_frames[3];
+			glm::vec2 pos = (&game.players[i] == game.player ? game.player_draw_pos : game.players[i].pos);
+			instances.emplace_back(pos - camera, game.players[i].size, frame, colors[i]);
 		}
-	}, 0.0);
-}
+	}
 
-void PlayMode::random_spawn() {
-	// pick player spawn
-	player->pos = spawns[rand() % spawns.size()];
-	player->vel = glm::vec2(0.0f, 0.0f);
+	for (uint8_t i = 0; i < Game::MAX_PLAYERS; i++) {
+		glm::vec2 pos = (&game.players[i] == game.player ? game.player_draw_pos : game.players[i].pos);
+		if (game.players[i].exists && game.players[i].it) instances.emplace_back(pos + glm::vec2(0.0f, -TILE_SIZE) - camera, game.players[i].size, it_frame, glm::u8vec4(255, 255, 255, 255));
+	}
 }
 
-void PlayMode::drawTexture(std::vector< Vertex > &vertices, glm::vec2 pos, glm::vec2 size, glm::vec2 tilepos, glm::vec2 tilesize, glm::u8vec4 color, float rotation) {
-
-	glm::mat4 rotate_around_origin_mat = glm::mat4(
-		glm::vec4(glm::cos(rotation), -glm::sin(rotation), 0.0f, 0.0f),
-		glm::vec4(glm::sin(rotation), glm::cos(rotation), 0.0f, 0.0f),
-		glm::vec4(0.0f, 0.0f, 1.0f, 0.0f),
-		glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)
-	);
-
-	glm::vec2 rotation_center_2d = pos + 0.5f * size;
-
-	glm::mat4 translate_to_origin_mat = glm::mat4(
-		glm::vec4(1.0f, 0.0f, 0.0f, 0.0f),
-		glm::vec4(0.0f, 1.0f, 0.0f, 0.0f),
-		glm::vec4(0.0f, 0.0f, 1.0f, 0.0f),
-		glm::vec4(-rotation_center_2d.x, -rotation_center_2d.y, 0.0f, 1.0f)
-	);
-
-	glm::mat4 translate_to_center_mat = glm::mat4(
-		glm::vec4(1.0f, 0.0f, 0.0f, 0.0f),
-		glm::vec4(0.0f, 1.0f, 0.0f, 0.0f),
-		glm::vec4(0.0f, 0.0f, 1.0f, 0.0f),
-		glm::vec4(rotation_center_2d.x, rotation_center_2d.y, 0.0f, 1.0f)
-	);
-
-	glm::mat4 rotate_around_center_mat = translate_to_center_mat * rotate_around_origin_mat * translate_to_origin_mat;
-
-	//inline helper function for textured rectangle drawing:
-	auto draw_tex_rectangle = [&vertices, &rotate_around_center_mat](glm::vec2 const &pos, glm::vec2 const &size, glm::vec2 const &tilepos, glm::vec2 const &tilesize, glm::u8vec4 const &color) {
-		// bot_left will be top left on screen after clip transformation
-		glm::vec4 bot_left = rotate_around_center_mat * glm::vec4(pos.x, pos.y, 0.0f, 1.0f);
-		glm::vec4 bot_right = rotate_around_center_mat * glm::vec4(pos.x+size.x, pos.y, 0.0f, 1.0f);
-		glm::vec4 top_right = rotate_around_center_mat * glm::vec4(pos.x+size.x, pos.y+size.y, 0.0f, 1.0f);
-		glm::vec4 top_left = rotate_around_center_mat * glm::vec4(pos.x, pos.y+size.y, 0.0f, 1.0f);
-
-		//draw rectangle as two CCW-oriented triangles:
-		vertices.emplace_back(glm::vec3(bot_left), color, glm::vec2(tilepos.x, tilepos.y));
-		vertices.emplace_back(glm::vec3(bot_right), color, glm::vec2(tilepos.x+tilesize.x, tilepos.y));
-		vertices.emplace_back(glm::vec3(top_right), color, glm::vec2(tilepos.x+tilesize.x, tilepos.y+tilesize.y));
-
-		vertices.emplace_back(glm::vec3(bot_left), color, glm::vec2(tilepos.x, tilepos.y));
-		vertices.emplace_back(glm::vec3(top_right), color, glm::vec2(tilepos.x+tilesize.x, tilepos.y+tilesize.y));
-		vertices.emplace_back(glm::vec3(top_left), color, glm::vec2(tilepos.x, tilepos.y+tilesize.y));
+//index into PlayMode::GlyphAlphabet for every byte (NoGlyph if it has none):
+namespace {
+	constexpr uint8_t NoGlyph = 0xff;
+	struct GlyphTable {
+		uint8_t index[256];
 	};
-
-	tilepos = glm::vec2(tilepos.x * TILE_SIZE / tileset_size.x, tilepos.y * TILE_SIZE / tileset_size.y);
-	tilesize = glm::vec2(tilesize.x * TILE_SIZE / tileset_size.x, tilesize.y * TILE_SIZE / tileset_size.y);
-	draw_tex_rectangle(pos, size, tilepos, tilesize, color);
-}
-
-void PlayMode::drawBackground(std::vector< Vertex > &vertices) {
-	glm::vec2 pos1 = glm::vec2(1.0f, 1.0f) * TILE_SIZE;
-	glm::vec2 size1 = glm::vec2(51.0f, 50.0f) * TILE_SIZE;
-
-	glm::vec2 pos2 = glm::vec2(22.0f, 51.0f) * TILE_SIZE;
-	glm::vec2 size2 = glm::vec2(9.0f, 39.0f) * TILE_SIZE;
-
-	drawTexture(vertices, pos1 - camera, size1, glm::vec2(2.0f, 0.0f), glm::vec2(1.0f, 1.0f), glm::u8vec4(255, 255, 255, 255), 0.0f);
-	drawTexture(vertices, pos2 - camera, size2, glm::vec2(2.0f, 0.0f), glm::vec2(1.0f, 1.0f), glm::u8vec4(255, 255, 255, 255), 0.0f);
-}
-
-void PlayMode::drawWalls(std::vector< Vertex > &vertices) {
-	for (auto const &wall : walls) {
-		drawTexture(vertices, wall.pos - camera, wall.size, glm::vec2(0.0f, wall.tile_variant), glm::vec2(1.0f, 1.0f), glm::u8vec4(255, 255, 255, 255), 0.0f);
+	constexpr GlyphTable make_glyph_table() {
+		GlyphTable table{};
+		for (uint32_t c = 0; c < 256; ++c) table.index[c] = NoGlyph;
+		for (uint32_t j = 0; j < PlayMode::GlyphCount; ++j) table.index[uint8_t(PlayMode::GlyphAlphabet[j])] = uint8_t(j);
+		return table;
 	}
+	constexpr GlyphTable glyph_table = make_glyph_table();
+	static_assert(glyph_table.index[uint8_t('A')] == 0 && glyph_table.index[uint8_t(' ')] == PlayMode::GlyphCount - 1 && glyph_table.index[uint8_t('a')] == NoGlyph, "glyph table matches alphabet");
 }
 
-void PlayMode::drawPlayers(std::vector< Vertex > &vertices) {
-	
-	for (uint8_t i = 0; i < MAX_PLAYERS; i++) {
-		if (players[i].exists) {
-			glm::vec2 tilepos = glm::vec2(1.0f, 0.0f);
-			if (players[i].sliding_right) tilepos.y = 1.0f;
-			else if (players[i].sliding_left) tilepos.y = 2.0f;
-			else if (players[i].airborne) tilepos.y = 3.0f;
-			drawTexture(vertices, players[i].pos - camera, players[i].size, tilepos, glm::vec2(1.0f, 1.0f), colors[i], 0.0f);
+void PlayMode::drawString(TextRun &run, char const *text, glm::vec2 at, glm::u8vec4 color) {
+	if (run.text != text || run.at != at || run.color != color) {
+		run.text = text;
+		run.at = at;
+		run.color = color;
+		run.instances.clear();
+		float s = 2.0f;
+		for (size_t i = 0; i < run.text.size(); i++) {
+			uint8_t j = glyph_table.index[uint8_t(run.text[i])];
+			if (j == NoGlyph) continue;
+			run.instances.emplace_back(at + float(i) * s * glm::vec2(12.0f, 0.0f), s * glm::vec2(11.0f, 13.0f), glyph_frames[j], color);
 		}
 	}
-
-	for (uint8_t i = 0; i < MAX_PLAYERS; i++) {
-		if (players[i].exists && players[i].it) drawTexture(vertices, players[i].pos + glm::vec2(0.0f, -TILE_SIZE) - camera, players[i].size, glm::vec2(1.0f, 4.0f), glm::vec2(1.0f, 1.0f), glm::u8vec4(255, 255, 255, 255), 0.0f);
-	}
+	sprite_instances.instances.insert(sprite_instances.instances.end(), run.instances.begin(), run.instances.end());
 }
 
-void PlayMode::drawText(std::vector< Vertex > &vertices) {
-	auto draw_string = [&](std::string str, glm::vec2 at, glm::u8vec4 color) {
-		std::string alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789. ";
-
-		for (int i = 0; i < str.size(); i++) {
-			for (int j = 0; j < alphabet.size(); j++) {
-				if (str[i] == alphabet[j]) {
-					float s = 2.0f;
-					drawTexture(vertices, at + (float) i * s * glm::vec2(12.0f, 0.0f), s * glm::vec2(11.0f, 13.0f), glm::vec2(0.0f, 7.0f) + (float) j * glm::vec2(11.0f / 20.0f, 0.0f), glm::vec2(11.0f / 20.0f, 13.0f / 20.0f), color, 0.0f);
-				}
-			}
-		}
-	};
-
-	std::string color_names[] = {
+void PlayMode::drawText() {
+	static constexpr char const *color_names[Game::MAX_PLAYERS] = {
 		"GREEN",
 		"RED",
 		"PURPLE",
@@ -462,31 +195,42 @@ void PlayMode::drawText(std::vector< Vertex > &vertices) {
 		"PINK"
 	};
 
-	std::string whoisit = "";
+	//(fixed buffers, so nothing here allocates unless some text actually changed)
+	char line[64];
 
-	int i = 0;
-	for (; i < MAX_PLAYERS; i++) {
-		if (players[i].it) {
-			whoisit = color_names[i] + " IS IT";
+	line[0] = '\0';
+	glm::u8vec4 it_color = glm::u8vec4(255, 255, 255, 255);
+	for (uint8_t i = 0; i < Game::MAX_PLAYERS; i++) {
+		if (game.players[i].it) {
+			std::snprintf(line, sizeof(line), "%s IS IT", color_names[i]);
+			it_color = colors[i];
 			break;
 		}
 	}
+	float width = std::strlen(line) * 12.0f * 2.0f;
+	drawString(it_text, line, glm::vec2(-0.5f * width, -0.4f * WINDOW_SIZE.y), it_color);
 
-	float width = whoisit.size() * 12.0f * 2.0f;
-	draw_string(whoisit, glm::vec2(-0.5f * width, -0.4f * WINDOW_SIZE.y), colors[i]);
+	if (show_net_stats) {
+		auto ms = [](double seconds) {
+			return int(std::round(std::abs(seconds) * 1000.0));
+		};
+		glm::u8vec4 white = glm::u8vec4(255, 255, 255, 255);
+		std::snprintf(line, sizeof(line), "RTT %d MS JITTER %d MS", ms(game.server_clock.rtt), ms(game.server_clock.jitter));
+		drawString(rtt_text, line, glm::vec2(-0.5f * WINDOW_SIZE.x + 10.0f, 0.5f * WINDOW_SIZE.y - 70.0f), white);
+		std::snprintf(line, sizeof(line), "CLOCK %s %d MS", (game.server_clock.offset < 0.0 ? "BEHIND" : "AHEAD"), ms(game.server_clock.offset));
+		drawString(offset_text, line, glm::vec2(-0.5f * WINDOW_SIZE.x + 10.0f, 0.5f * WINDOW_SIZE.y - 40.0f), white);
+		std::snprintf(line, sizeof(line), "SPRITES %u DRAWS %u BYTES %llu",
+			unsigned(last_instance_stats.sprites),
+			unsigned(last_instance_stats.flushes),
+			(unsigned long long)(last_instance_stats.bytes_uploaded));
+		drawString(sprites_text, line, glm::vec2(-0.5f * WINDOW_SIZE.x + 10.0f, 0.5f * WINDOW_SIZE.y - 100.0f), white);
+	}
 }
 
 void PlayMode::draw(glm::uvec2 const &drawable_size) {
 	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 	glClear(GL_COLOR_BUFFER_BIT);
 
-	std::vector< Vertex > vertices;
-
-	drawBackground(vertices);
-	drawWalls(vertices);
-	drawPlayers(vertices);
-	drawText(vertices);
-
 	glm::mat4 pixels_to_clip = glm::mat4(
 		glm::vec4(2.0f / WINDOW_SIZE.x, 0.0f, 0.0f, 0.0f),
 		glm::vec4(0.0f, -2.0f / WINDOW_SIZE.y, 0.0f, 0.0f),
@@ -494,41 +238,51 @@ void PlayMode::draw(glm::uvec2 const &drawable_size) {
 		glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)
 	);
 
+	//level geometry is in level coordinates, so it gets the camera offset as well:
+	glm::mat4 level_to_clip = pixels_to_clip * glm::mat4(
+		glm::vec4(1.0f, 0.0f, 0.0f, 0.0f),
+		glm::vec4(0.0f, 1.0f, 0.0f, 0.0f),
+		glm::vec4(0.0f, 0.0f, 1.0f, 0.0f),
+		glm::vec4(-camera.x, -camera.y, 0.0f, 1.0f)
+	);
+
 	//use alpha blending:
 	glEnable(GL_BLEND);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 	//don't use the depth test:
 	glDisable(GL_DEPTH_TEST);
 
-	//upload vertices to vertex_buffer:
-	glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer); //set vertex_buffer as current
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(vertices[0]), vertices.data(), GL_STREAM_DRAW); //upload vertices array
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-	//set color_texture_program as current program:
-	glUseProgram(color_texture_program->program);
-
-	//upload OBJECT_TO_CLIP to the proper uniform location:
-	glUniformMatrix4fv(color_texture_program->OBJECT_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(pixels_to_clip));
-
-	//use the mapping vertex_buffer_for_color_texture_program to fetch vertex data:
-	glBindVertexArray(vertex_buffer_for_color_texture_program);
-
-	//bind the solid white texture to location zero so things will be drawn just with their colors:
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, tileset_tex);
-
-	//run the OpenGL pipeline:
-	glDrawArrays(GL_TRIANGLES, 0, GLsizei(vertices.size()));
+	if (use_tilemap) {
+		//just the background quads from level_buffer:
+		level_first.assign(1, 0);
+		level_count.assign(1, GLsizei(6 * LevelGeometry::BackgroundQuads));
+	} else {
+		//only the chunks of the level that are on screen (with a tile of margin):
+		glm::vec2 view_radius = 0.5f * glm::vec2(WINDOW_SIZE) + glm::vec2(TILE_SIZE);
+		level_geometry.visible(camera - view_radius, camera + view_radius, level_first, level_count);
+	}
 
-	//unbind the solid white texture:
-	glBindTexture(GL_TEXTURE_2D, 0);
+	{ //draw the level first (it's underneath everything else):
+		glUseProgram(color_texture_program->program);
+		glUniformMatrix4fv(color_texture_program->OBJECT_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(level_to_clip));
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, tileset_tex);
+		glBindVertexArray(level_buffer_for_color_texture_program);
+		glMultiDrawArrays(GL_TRIANGLES, level_first.data(), level_count.data(), GLsizei(level_first.size()));
+		glBindVertexArray(0);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		glUseProgram(0);
 
-	//reset vertex array to none:
-	glBindVertexArray(0);
+		//walls, as one quad looking up tiles in tilemap's texture:
+		if (use_tilemap) tilemap.draw(level_to_clip, tileset_tex, tileset_size);
+	}
 
-	//reset current program to none:
-	glUseProgram(0);
+	//then players + text, which change from frame to frame:
+	last_instance_stats = sprite_instances.stats;
+	sprite_instances.begin(pixels_to_clip);
+	drawPlayers();
+	drawText();
+	sprite_instances.flush();
 
 	GL_ERRORS();
 }
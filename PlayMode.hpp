@@ -1,15 +1,21 @@
 #include "Mode.hpp"
 
-#include "Connection.hpp"
+#include "Game.hpp"
+#include "LevelGeometry.hpp"
+#include "TilemapLayer.hpp"
+#include "SpriteInstanceBatch.hpp"
 
 #include "GL.hpp"
 #include <glm/glm.hpp>
 
 #include <vector>
+#include <string>
 #include <deque>
+#include <memory>
 
 struct PlayMode : Mode {
-	PlayMode(Client &client);
+	//if use_net_thread is set, the connection is serviced on a background thread (see Game):
+	PlayMode(Client &client, bool use_net_thread = false);
 	virtual ~PlayMode();
 
 	//functions called by main loop:
@@ -21,68 +27,45 @@ struct PlayMode : Mode {
 	GLuint tileset_tex = 0;
 	glm::vec2 tileset_size;
 
-	struct Vertex {
-		Vertex(glm::vec3 const &Position_, glm::u8vec4 const &Color_, glm::vec2 const &TexCoord_) :
-			Position(Position_), Color(Color_), TexCoord(TexCoord_) { }
-		glm::vec3 Position;
-		glm::u8vec4 Color;
-		glm::vec2 TexCoord;
-	};
-	static_assert(sizeof(Vertex) == 4*3 + 1*4 + 4*2, "BoatMode::Vertex should be packed");
-
-	GLuint vertex_buffer = 0;
-	GLuint vertex_buffer_for_color_texture_program = 0;
+	typedef SpriteVertex Vertex;
+
+	//players + text, rebuilt every frame (as instances, from these frames of the tileset):
+	SpriteInstanceBatch sprite_instances;
+	uint16_t player_frames[4]; //standing, sliding right, sliding left, airborne
+	uint16_t it_frame;
+	//HUD font -- glyphs appear in the tileset in this order (other characters are skipped):
+	static constexpr char GlyphAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789. ";
+	static constexpr uint32_t GlyphCount = sizeof(GlyphAlphabet) - 1;
+	uint16_t glyph_frames[GlyphCount];
+	//previous frame's stats (shown with the net stats):
+	SpriteInstanceBatch::Stats last_instance_stats;
+
+	//background + walls, built once (in level coordinates; the camera is applied in OBJECT_TO_CLIP):
+	GLuint level_buffer = 0;
+	GLuint level_buffer_for_color_texture_program = 0;
+	//ranges of level_buffer the camera can see (from level_geometry.visible(); kept to avoid reallocating):
+	std::vector< GLint > level_first;
+	std::vector< GLsizei > level_count;
 
 	//----- game state -----
 
-	//input tracking:
-	struct Button {
-		uint8_t pressed = 0;
-	} left, right, up, space;
-
-	//last message from server:
-	std::string server_message;
+	//everything but the drawing:
+	Game game;
 
-	//connection to server:
-	Client &client;
+	//show game.server_clock's estimates on the HUD (toggled with F3):
+	bool show_net_stats = false;
 
 	const glm::uvec2 WINDOW_SIZE = glm::uvec2(640, 640);
 	const float TILE_SIZE = 20.0f;
-	const float WALL_SIZE = TILE_SIZE;
 
-	struct Wall {
-		glm::vec2 pos;
-		glm::vec2 size;
-		unsigned int tile_variant = 0;
-		Wall(glm::vec2 _pos, glm::vec2 _size): pos(_pos), size(_size) { }
-	};
-	struct Outerwall {
-		glm::vec2 pos;
-		Outerwall(glm::vec2 _pos): pos(_pos) { }
-	};
+	//wall sprites (what goes in level_buffer):
+	LevelGeometry level_geometry;
+	//the same walls, drawn by a shader from a texture of tile cells:
+	TilemapLayer tilemap;
+	//draw walls with tilemap rather than level_buffer's chunks (toggled with F4):
+	bool use_tilemap = true;
 
-	std::vector<Wall> walls;
-	std::vector<Wall> obwalls;
-	std::vector<glm::uvec2> spawns;
-
-	struct Player {
-		glm::vec2 pos;
-		glm::vec2 size;
-		glm::vec2 vel = glm::vec2(0.0f, 0.0f);
-		uint8_t color = 0; // equal to index in players[]
-		bool it = false;
-		bool exists = false;
-		bool airborne = false;
-		bool sliding_left = false;
-		bool sliding_right = false;
-		Player() {
-			pos = glm::vec2(0.0f, 0.0f);
-			size = glm::vec2(20.0f, 20.0f);
-		}
-	};
-
-	static const uint8_t MAX_PLAYERS = 8;
-	const glm::u8vec4 colors[MAX_PLAYERS] = {
+	const glm::u8vec4 colors[Game::MAX_PLAYERS] = {
 		glm::u8vec4(94, 157, 91, 255),
 		glm::u8vec4(255, 91, 50, 255),
 		glm::u8vec4(179, 44, 255, 255),
@@ -93,25 +76,19 @@ struct PlayMode : Mode {
 		glm::u8vec4(255, 9, 255, 255)
 	};
 
-	Player players[MAX_PLAYERS];
-	Player *player = nullptr;
-
-	const float X_DECEL = 50000.0f;
-	const float X_ACCEL = 200000.0f;
-	const float MAX_X_SPEED = 400.0f;
-	const float MIN_X_SPEED = 50.0f;
-	const float MAX_SLIDE_SPEED = 200.0f;
-	const float JUMP_IMPULSE = 700.0f;
-	const float WALL_JUMP_Y_IMPULSE = 700.0f;
-	const float WALL_JUMP_X_IMPULSE = 500.0f;
-	const float GRAVITY = 1666.0f;
-	bool can_jump = false;
 	glm::vec2 camera;
 
-	void random_spawn();
-	void drawWalls(std::vector< Vertex > &vertices);
-	void drawBackground(std::vector< Vertex > &vertices);
-	void drawPlayers(std::vector< Vertex > &vertices);
-	void drawText(std::vector< Vertex > &vertices);
-	void drawTexture(std::vector< Vertex > &vertices, glm::vec2 pos, glm::vec2 size, glm::vec2 tilepos, glm::vec2 tilesize, glm::u8vec4 color, float rotation);
+	//a line of HUD text, turned into glyph instances only when it changes:
+	struct TextRun {
+		std::string text; //as of the last rebuild
+		glm::vec2 at = glm::vec2(0.0f);
+		glm::u8vec4 color = glm::u8vec4(0);
+		std::vector< SpriteInstance > instances;
+	};
+	TextRun it_text, rtt_text, offset_text, sprites_text;
+
+	//append to sprite_instances:
+	void drawPlayers();
+	void drawText();
+	void drawString(TextRun &run, char const *text, glm::vec2 at, glm::u8vec4 color);
 };
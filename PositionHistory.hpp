@@ -0,0 +1,59 @@
+#pragma once
+
+/*
+ * PositionHistory is a fixed-size ring buffer of timestamped positions,
+ * recorded once per server tick. It lets the server ask "where was this
+ * player at time t?" (e.g., to judge a lagged client against what it
+ * actually saw) without any allocation.
+ */
+
+#include <cstdint>
+
+struct PositionHistory {
+	//at a 60Hz tick this covers a bit over half a second, which is more than any playable ping:
+	static constexpr uint32_t Size = 32;
+
+	struct Sample {
+		double time = 0.0; //seconds
+		float x = 0.0f;
+		float y = 0.0f;
+	};
+	Sample samples[Size];
+	uint32_t newest = 0; //index of the most recent sample
+	uint32_t count = 0; //number of valid samples
+
+	void record(double time, float x, float y) {
+		newest = (newest + 1) % Size;
+		samples[newest].time = time;
+		samples[newest].x = x;
+		samples[newest].y = y;
+		if (count < Size) count += 1;
+	}
+
+	//position at 'time', interpolated between the samples around it
+	// (clamped to the oldest/newest sample; returns false if there are no samples):
+	bool at(double time, float *x, float *y) const {
+		if (count == 0) return false;
+		Sample const *after = &samples[newest];
+		if (time >= after->time) {
+			*x = after->x;
+			*y = after->y;
+			return true;
+		}
+		//walk back from the newest sample until we pass 'time':
+		for (uint32_t i = 1; i < count; ++i) {
+			Sample const *before = &samples[(newest + Size - i) % Size];
+			if (before->time <= time) {
+				float amt = float((time - before->time) / (after->time - before->time));
+				*x = before->x + (after->x - before->x) * amt;
+				*y = before->y + (after->y - before->y) * amt;
+				return true;
+			}
+			after = before;
+		}
+		//older than anything recorded:
+		*x = after->x;
+		*y = after->y;
+		return true;
+	}
+};
@@ -0,0 +1,120 @@
+#include "RenderQueue.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+uint64_t RenderQueue::make_key(uint32_t program, uint32_t vertex_array, uint32_t textures, float depth) {
+	auto field = [](uint32_t value, uint32_t bits) -> uint64_t {
+		return std::min< uint64_t >(value, (uint64_t(1) << bits) - 1);
+	};
+	//NaN and out-of-range depths go to the ends:
+	float d = (depth >= 0.0f ? std::min(depth, 1.0f) : 0.0f);
+	uint64_t depth_bits = uint64_t(std::lround(d * float((1u << DepthBits) - 1)));
+
+	//(the largest program field is left for InOrderKey)
+	uint64_t program_bits = std::min< uint64_t >(program, (uint64_t(1) << ProgramBits) - 2);
+
+	return (program_bits << (VertexArrayBits + TexturesBits + DepthBits))
+	     | (field(vertex_array, VertexArrayBits) << (TexturesBits + DepthBits))
+	     | (field(textures, TexturesBits) << DepthBits)
+	     | depth_bits;
+}
+
+uint32_t RenderQueue::Ids::operator()(uint64_t name) {
+	auto ret = ids.emplace(name, uint32_t(ids.size()));
+	return ret.first->second;
+}
+
+void RenderQueue::clear() {
+	program_ids.clear();
+	vertex_array_ids.clear();
+	texture_ids.clear();
+	items.clear();
+}
+
+void RenderQueue::sort() {
+	if (items.size() < 2) return;
+
+	//count every byte of every key in one pass:
+	uint32_t counts[8][256] = {};
+	for (auto const &item : items) {
+		for (uint32_t b = 0; b < 8; ++b) {
+			counts[b][(item.key >> (8 * b)) & 0xff] += 1;
+		}
+	}
+
+	scratch.resize(items.size());
+	for (uint32_t b = 0; b < 8; ++b) {
+		//every key has the same byte here, so this pass wouldn't move anything:
+		if (counts[b][(items[0].key >> (8 * b)) & 0xff] == items.size()) continue;
+
+		uint32_t offsets[256];
+		uint32_t sum = 0;
+		for (uint32_t i = 0; i < 256; ++i) {
+			offsets[i] = sum;
+			sum += counts[b][i];
+		}
+		for (auto const &item : items) {
+			scratch[offsets[(item.key >> (8 * b)) & 0xff]++] = item;
+		}
+		items.swap(scratch);
+	}
+}
+
+//------------------------------------------
+
+bool RenderQueue::StateCache::use_program(uint32_t program_) {
+	if (program == program_) return false;
+	program = program_;
+	stats.programs += 1;
+	return true;
+}
+
+bool RenderQueue::StateCache::bind_vertex_array(uint32_t vertex_array_) {
+	if (vertex_array == vertex_array_) return false;
+	vertex_array = vertex_array_;
+	stats.vertex_arrays += 1;
+	return true;
+}
+
+bool RenderQueue::StateCache::active_texture(uint32_t unit) {
+	if (active_unit == unit) return false;
+	active_unit = unit;
+	stats.active_textures += 1;
+	return true;
+}
+
+bool RenderQueue::StateCache::bind_material(uint32_t material_) {
+	if (material == material_) return false;
+	material = material_;
+	stats.buffer_ranges += 1;
+	return true;
+}
+
+bool RenderQueue::StateCache::bind_texture(uint32_t unit, uint32_t target, uint32_t texture, uint32_t *unbind) {
+	Binding &binding = bindings[unit];
+	*unbind = 0;
+	if (texture == 0) {
+		if (binding.texture != 0) {
+			*unbind = binding.target;
+			stats.textures += 1;
+		}
+		binding = Binding();
+		return false;
+	}
+	if (binding.target == target && binding.texture == texture) return false;
+	if (binding.texture != 0 && binding.target != target) {
+		*unbind = binding.target;
+		stats.textures += 1;
+	}
+	binding.target = target;
+	binding.texture = texture;
+	stats.textures += 1;
+	return true;
+}
+
+void RenderQueue::StateCache::count_unsorted(uint32_t textures) {
+	//glUseProgram + glBindVertexArray, then for each texture glActiveTexture + glBindTexture
+	// before the draw and again after it, then a final glActiveTexture(GL_TEXTURE0):
+	stats.unsorted_calls += 2 + 4 * textures + 1;
+}
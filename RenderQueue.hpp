@@ -0,0 +1,110 @@
+#pragma once
+
+/*
+ * RenderQueue puts a frame's draws in an order where draws that share GL state
+ * sit next to each other, and tracks the GL state already bound, so the state
+ * only changes when a draw actually needs something different.
+ *
+ * Each draw gets a 64-bit sort key, packed most-significant first:
+ *   program (12 bits) | vertex array (14 bits) | textures (22 bits) | depth (16 bits)
+ * Program, vertex array, and texture set are small ids handed out per frame (see
+ * Ids), not GL names. Depth sorts otherwise-equal draws front to back. Keys only
+ * decide the order, and StateCache decides which calls to issue, so two texture
+ * sets that share an id make the order worse but never the rendering wrong.
+ *
+ * It doesn't depend on OpenGL, so it can be run headless (see bench-scene.cpp).
+ * Scene::draw is its main user.
+ */
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+struct RenderQueue {
+	static constexpr uint32_t ProgramBits = 12;
+	static constexpr uint32_t VertexArrayBits = 14;
+	static constexpr uint32_t TexturesBits = 22;
+	static constexpr uint32_t DepthBits = 16;
+	static_assert(ProgramBits + VertexArrayBits + TexturesBits + DepthBits == 64, "keys use all 64 bits");
+
+	//pack a key (ids past their field's range are clamped to the largest value, and programs
+	// to one less, so make_key() never returns InOrderKey):
+	// depth is 0 (nearest) to 1 (farthest)
+	static uint64_t make_key(uint32_t program, uint32_t vertex_array, uint32_t textures, float depth);
+	//key for draws that must keep the order they were pushed in (e.g. blended ones):
+	// sorts after every make_key() key, and sort() is stable, so these stay in push order at the end
+	static constexpr uint64_t InOrderKey = ~uint64_t(0);
+
+	//small ids for GL names (or hashes of texture sets), in order of first use since clear():
+	struct Ids {
+		uint32_t operator()(uint64_t name);
+		void clear() { ids.clear(); }
+		std::unordered_map< uint64_t, uint32_t > ids;
+	};
+	Ids program_ids, vertex_array_ids, texture_ids;
+
+	struct Item {
+		uint64_t key;
+		uint32_t index; //caller's draw index
+	};
+	std::vector< Item > items;
+
+	//start a new frame (keeps allocations):
+	void clear();
+	void push(uint64_t key, uint32_t index) { items.push_back(Item{key, index}); }
+	//order items by key (LSD radix sort, a byte per pass; passes over bytes all keys share are
+	// skipped; stable, so equal keys stay in the order they were pushed):
+	void sort();
+	std::vector< Item > scratch; //sort()'s second buffer
+
+	//GL calls made (or that would be made) while drawing:
+	struct Stats {
+		uint32_t draws = 0;
+		uint32_t programs = 0; //glUseProgram
+		uint32_t vertex_arrays = 0; //glBindVertexArray
+		uint32_t textures = 0; //glBindTexture
+		uint32_t active_textures = 0; //glActiveTexture
+		uint32_t calls() const { return programs + vertex_arrays + textures + active_textures; }
+		//state calls the old unsorted loop would have made for the same draws:
+		// (set everything for each draw, and unbind its textures afterward)
+		uint32_t unsorted_calls = 0;
+
+		//per-draw parameters:
+		uint32_t uniforms = 0; //glUniform* (for matrices not in a uniform block)
+		uint32_t buffer_ranges = 0; //glBindBufferRange (for uniform blocks)
+		uint32_t set_uniforms = 0; //per-draw uniform callbacks (the slow path)
+		uint32_t materials = 0; //distinct material blocks
+		uint32_t uniform_bytes = 0; //uniform buffer data uploaded
+		//glUniform* calls the old loop would have made for the matrices (one per matrix per draw):
+		uint32_t unbatched_uniforms = 0;
+	};
+
+	//the GL state that is bound, which decides what each draw needs to change:
+	// (the 'use'/'bind' functions return true when the matching GL call is needed, and count it)
+	struct StateCache {
+		static constexpr uint32_t TextureUnits = 4;
+
+		uint32_t program = 0;
+		uint32_t vertex_array = 0;
+		uint32_t active_unit = -1U; //not known until the first active_texture()
+		uint32_t material = -1U; //caller's index of the material block bound
+		struct Binding {
+			uint32_t target = 0;
+			uint32_t texture = 0;
+		} bindings[TextureUnits];
+		Stats stats;
+
+		bool use_program(uint32_t program);
+		bool bind_vertex_array(uint32_t vertex_array);
+		bool active_texture(uint32_t unit);
+		bool bind_material(uint32_t material);
+		//make 'unit' hold texture (or nothing, if texture == 0):
+		// when 'unbind' gets a nonzero target, bind 0 to that target first (after active_texture(unit));
+		// when this returns true, bind texture to target.
+		// (the old texture is unbound when the target changes, or when the unit should hold nothing)
+		bool bind_texture(uint32_t unit, uint32_t target, uint32_t texture, uint32_t *unbind);
+
+		//count the calls the old loop made for one draw with 'textures' textures bound:
+		void count_unsorted(uint32_t textures);
+	};
+};
@@ -0,0 +1,154 @@
+#include "Rollback.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <cassert>
+
+Rollback::Rollback(Level const &level_, uint32_t rate, std::vector< SimState::Body > const &spawns_) : level(level_), params(rate), spawns(spawns_) {
+	assert(!spawns.empty());
+	std::memset(inputs, 0, sizeof(inputs));
+	std::memset(confirmed, 0, sizeof(confirmed));
+	std::fill(slot_frame, slot_frame + Slots, -1U);
+	std::memset(last_confirmed, 0, sizeof(last_confirmed));
+	std::fill(last_confirmed_frame, last_confirmed_frame + SimState::MaxPlayers, 0);
+}
+
+void Rollback::join(uint8_t index) {
+	assert(index < SimState::MaxPlayers);
+	uint8_t bit = uint8_t(1 << index);
+	state.exists |= bit;
+	state.it &= ~bit;
+	state.bodies[index] = spawns[index % spawns.size()];
+	for (uint32_t i = 0; i < SimState::MaxPlayers; ++i) {
+		state.touching[i] &= ~bit;
+	}
+	state.touching[index] = 0;
+	last_confirmed[index] = 0;
+	last_confirmed_frame[index] = state.frame;
+	first_frame = state.frame;
+}
+
+void Rollback::leave(uint8_t index) {
+	assert(index < SimState::MaxPlayers);
+	uint8_t bit = uint8_t(1 << index);
+	state.exists &= ~bit;
+	state.it &= ~bit;
+	for (uint32_t i = 0; i < SimState::MaxPlayers; ++i) {
+		state.touching[i] &= ~bit;
+	}
+	state.touching[index] = 0;
+	first_frame = state.frame;
+}
+
+void Rollback::prepare_slot(uint32_t f) {
+	uint32_t s = f % Slots;
+	if (slot_frame[s] == f) return;
+	slot_frame[s] = f;
+	confirmed[s] = 0;
+	std::memcpy(inputs[s], last_confirmed, sizeof(last_confirmed));
+}
+
+bool Rollback::add_input(uint8_t index, uint32_t frame, Input const &input) {
+	if (index >= SimState::MaxPlayers) return false;
+	//too old to correct (its saved state may be gone) or too far ahead to have a slot:
+	if (frame < first_frame || frame + Window <= state.frame || frame >= state.frame + Window) return false;
+
+	uint8_t bits = pack(input);
+	bool mispredicted = false;
+	auto set_input = [&](uint32_t f) {
+		uint8_t &slot = inputs[f % Slots][index];
+		if (slot == bits) return;
+		slot = bits;
+		if (f < state.frame) {
+			mispredicted = true;
+			rewind_to = std::min(rewind_to, f);
+		}
+	};
+
+	prepare_slot(frame);
+	confirmed[frame % Slots] |= uint8_t(1 << index);
+	set_input(frame);
+
+	if (frame >= last_confirmed_frame[index]) {
+		last_confirmed[index] = bits;
+		last_confirmed_frame[index] = frame;
+		//later frames were predicted from an older input; predict this one instead:
+		for (uint32_t f = frame + 1; f < state.frame + Window && slot_frame[f % Slots] == f; ++f) {
+			if (!(confirmed[f % Slots] & (1 << index))) set_input(f);
+		}
+	}
+
+	return mispredicted;
+}
+
+void Rollback::advance() {
+	if (rewind_to < state.frame) {
+		uint32_t target = state.frame;
+		uint32_t from = std::max(rewind_to, first_frame);
+		std::memcpy(&state, &history[from % Slots], sizeof(SimState));
+		assert(state.frame == from);
+		rollbacks += 1;
+		resimulated_frames += target - from;
+		while (state.frame < target) {
+			simulate_frame();
+		}
+	}
+	rewind_to = -1U;
+	simulate_frame();
+}
+
+void Rollback::simulate_frame() {
+	uint32_t f = state.frame;
+	prepare_slot(f);
+	std::memcpy(&history[f % Slots], &state, sizeof(SimState));
+	step(state, inputs[f % Slots]);
+}
+
+void Rollback::step(SimState &sim, uint8_t const frame_inputs[SimState::MaxPlayers]) const {
+	//movement:
+	for (uint32_t i = 0; i < SimState::MaxPlayers; ++i) {
+		if (!(sim.exists & (1 << i))) continue;
+		if (GamePhysics::step(sim.bodies[i], unpack(frame_inputs[i]), params, level)) {
+			//falling into the pit makes you 'it' (and nobody else):
+			sim.it = uint8_t(1 << i);
+			sim.bodies[i] = spawns[(sim.frame + i) % spawns.size()];
+		}
+	}
+
+	//tags (same rules as the server: 'it' passes on when two players start touching):
+	for (uint32_t i = 0; i < SimState::MaxPlayers; ++i) {
+		if (!(sim.exists & (1 << i))) continue;
+		SimState::Body const &a = sim.bodies[i];
+		for (uint32_t j = i + 1; j < SimState::MaxPlayers; ++j) {
+			if (!(sim.exists & (1 << j))) continue;
+			SimState::Body const &b = sim.bodies[j];
+			bool touching = a.x < b.x + b.w && a.x + a.w > b.x && a.y < b.y + b.h && a.y + a.h > b.y;
+			bool was_touching = (sim.touching[i] >> j) & 1;
+			bool either_it = ((sim.it >> i) | (sim.it >> j)) & 1;
+			if (touching && !was_touching && either_it) {
+				sim.it ^= uint8_t((1 << i) | (1 << j));
+			}
+			if (touching) {
+				sim.touching[i] |= uint8_t(1 << j);
+				sim.touching[j] |= uint8_t(1 << i);
+			} else {
+				sim.touching[i] &= ~uint8_t(1 << j);
+				sim.touching[j] &= ~uint8_t(1 << i);
+			}
+		}
+	}
+
+	sim.frame += 1;
+}
+
+uint8_t Rollback::pack(Input const &input) {
+	return uint8_t(input.left) | uint8_t(input.right) << 1 | uint8_t(input.jump) << 2;
+}
+
+Rollback::Input Rollback::unpack(uint8_t bits) {
+	Input input;
+	input.left = bits & 1;
+	input.right = (bits >> 1) & 1;
+	input.jump = (bits >> 2) & 1;
+	return input;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+/*
+ * Rollback runs the whole game simulation (every player's movement plus tag
+ * state) from per-player inputs, in fixed frames.
+ *
+ * Inputs that haven't arrived yet are predicted (each player is assumed to
+ * keep doing whatever they last did). When a real input arrives that differs
+ * from the prediction, the state saved at the start of that frame is restored
+ * and the frames since are simulated again with the corrected inputs.
+ *
+ * The full simulation state is one flat, trivially copyable block (SimState),
+ * so saving and restoring a frame is a single memcpy.
+ *
+ * Re-simulated frames only reproduce what other machines computed if the
+ * movement step is deterministic; build with PHYSICS_FIXED_POINT for that
+ * (see Physics.hpp).
+ */
+
+#include "Physics.hpp"
+#include "Level.hpp"
+
+#include <vector>
+#include <cstdint>
+#include <type_traits>
+
+struct SimState {
+	static constexpr uint32_t MaxPlayers = 8;
+	typedef GamePhysics::Body Body;
+
+	uint32_t frame = 0; //number of frames simulated so far
+	uint8_t exists = 0; //bit i set if player i is in the game
+	uint8_t it = 0; //bit i set if player i is 'it'
+	uint8_t touching[MaxPlayers] = {0, 0, 0, 0, 0, 0, 0, 0}; //bit j of [i] set if i and j overlapped last frame
+	Body bodies[MaxPlayers];
+};
+static_assert(std::is_trivially_copyable< SimState >::value, "SimState is saved and restored with memcpy");
+
+struct Rollback {
+	//inputs can be corrected up to Window frames in the past, and arrive up to Window frames early:
+	static constexpr uint32_t Window = 32;
+	static constexpr uint32_t Slots = 2 * Window; //size of the per-frame rings
+
+	typedef GamePhysics::Input Input;
+
+	//'spawns' are bodies placed where players appear:
+	Rollback(Level const &level, uint32_t rate, std::vector< SimState::Body > const &spawns);
+
+	//add or remove player 'index' at the current frame:
+	// (frames before a join or leave can no longer be rolled back to)
+	void join(uint8_t index);
+	void leave(uint8_t index);
+
+	//record player 'index's real input for 'frame'; inputs outside the window are ignored:
+	// returns true if it differs from what was predicted (so the next advance() will roll back)
+	bool add_input(uint8_t index, uint32_t frame, Input const &input);
+
+	//simulate one frame (the local player's input should already have been added with add_input),
+	// first rolling back and re-simulating if any input since the last advance() was mispredicted:
+	void advance();
+
+	//advance 'state' by one frame with the given (packed) inputs, one per player:
+	void step(SimState &state, uint8_t const inputs[SimState::MaxPlayers]) const;
+
+	static uint8_t pack(Input const &input);
+	static Input unpack(uint8_t bits);
+
+	Level const &level;
+	GamePhysics::Params params;
+	std::vector< SimState::Body > spawns;
+
+	SimState state; //as of the start of frame state.frame
+
+	//stats:
+	uint32_t rollbacks = 0; //advance() calls that had to go back
+	uint32_t resimulated_frames = 0; //frames simulated again because of mispredictions
+
+	//internals:
+	SimState history[Slots]; //[f % Slots] is the state at the start of frame f
+	uint8_t inputs[Slots][SimState::MaxPlayers]; //[f % Slots][i] is the input (real or predicted) player i has for frame f
+	uint8_t confirmed[Slots]; //bit i of [f % Slots] set once player i's real input for frame f has arrived
+	uint32_t slot_frame[Slots]; //which frame the inputs in each slot belong to
+	uint8_t last_confirmed[SimState::MaxPlayers]; //latest real input from each player (what gets predicted)
+	uint32_t last_confirmed_frame[SimState::MaxPlayers];
+	uint32_t first_frame = 0; //can't roll back before this frame (set by join / leave)
+	uint32_t rewind_to = -1U; //earliest frame simulated with a wrong prediction (-1U if none)
+
+	//make slot f % Slots hold frame f's inputs (predicting any that haven't arrived):
+	void prepare_slot(uint32_t f);
+	//save the state, then simulate it by one frame:
+	void simulate_frame();
+};
@@ -1,11 +1,15 @@
 #include "Scene.hpp"
 
+#include "StreamBuffer.hpp"
 #include "gl_errors.hpp"
 #include "read_write_chunk.hpp"
 
 #include <glm/gtc/type_ptr.hpp>
 
 #include <fstream>
+#include <algorithm>
+#include <limits>
+#include <cstring>
 
 //-------------------------
 
@@ -80,18 +84,50 @@ glm::mat4 Scene::Camera::make_projection() const {
 //-------------------------
 
 
-void Scene::draw(Camera const &camera) const {
+void Scene::bind_uniform_blocks(GLuint program) {
+	GLuint object_index = glGetUniformBlockIndex(program, "Object");
+	if (object_index != GL_INVALID_INDEX) glUniformBlockBinding(program, object_index, ObjectBlockBinding);
+	GLuint material_index = glGetUniformBlockIndex(program, "Material");
+	if (material_index != GL_INVALID_INDEX) glUniformBlockBinding(program, material_index, MaterialBlockBinding);
+	GL_ERRORS();
+}
+
+void Scene::draw(Camera const &camera, RenderQueue::Stats *stats) const {
 	assert(camera.transform);
 	glm::mat4 world_to_clip = camera.make_projection() * glm::mat4(camera.transform->make_world_to_local());
 	glm::mat4x3 world_to_light = glm::mat4x3(1.0f);
-	draw(world_to_clip, world_to_light);
+	draw(world_to_clip, world_to_light, stats);
+}
+
+//inverse transpose of m (takes normals along with points transformed by m):
+// this is m's cofactor matrix over its determinant, and a degenerate m gives zeros (not NaNs)
+static glm::mat3 normal_matrix(glm::mat3 const &m) {
+	glm::vec3 c0 = glm::cross(m[1], m[2]);
+	glm::vec3 c1 = glm::cross(m[2], m[0]);
+	glm::vec3 c2 = glm::cross(m[0], m[1]);
+	float det = glm::dot(m[0], c0);
+	float inv_det = (det == 0.0f ? 0.0f : 1.0f / det);
+	return glm::mat3(c0 * inv_det, c1 * inv_det, c2 * inv_det);
+}
+
+void Scene::DrawQueue::clear() {
+	queue.clear();
+	drawables.clear();
+	distance.clear();
+	objects.clear();
+	material.clear();
+	materials.clear();
+	material_hashes.clear();
 }
 
-void Scene::draw(glm::mat4 const &world_to_clip, glm::mat4x3 const &world_to_light) const {
+void Scene::queue_drawables(glm::mat4 const &world_to_clip, glm::mat4x3 const &world_to_light, DrawQueue &draw_queue) const {
+	RenderQueue &queue = draw_queue.queue;
+	draw_queue.clear();
 
-	//Iterate through all drawables, sending each one to OpenGL:
+	//gather the drawables that will actually draw something (and their matrices):
+	float min_distance = std::numeric_limits< float >::infinity();
+	float max_distance = -std::numeric_limits< float >::infinity();
 	for (auto const &drawable : drawables) {
-		//Reference to drawable's pipeline for convenience:
 		Scene::Drawable::Pipeline const &pipeline = drawable.pipeline;
 
 		//skip any drawables without a shader program set:
@@ -101,70 +137,281 @@ void Scene::draw(glm::mat4 const &world_to_clip, glm::mat4x3 const &world_to_lig
 		//skip any drawables that don't contain any vertices:
 		if (pipeline.count == 0) continue;
 
+		//the object-to-world matrix is used in all three matrices:
+		assert(drawable.transform); //drawables *must* have a transform
+		glm::mat4 object_to_world = glm::mat4(drawable.transform->make_local_to_world());
 
-		//Set shader program:
-		glUseProgram(pipeline.program);
+		ObjectBlock object;
+		//OBJECT_TO_CLIP takes vertices from object space to clip space:
+		object.OBJECT_TO_CLIP = world_to_clip * object_to_world;
+		//OBJECT_TO_LIGHT takes vertices from object space to light space:
+		glm::mat4x3 object_to_light = world_to_light * object_to_world;
+		for (uint32_t c = 0; c < 4; ++c) object.OBJECT_TO_LIGHT[c] = glm::vec4(object_to_light[c], 0.0f);
+		//NORMAL_TO_LIGHT takes normals from object space to light space:
+		glm::mat3 normal_to_light = normal_matrix(glm::mat3(object_to_light));
+		for (uint32_t c = 0; c < 3; ++c) object.NORMAL_TO_LIGHT[c] = glm::vec4(normal_to_light[c], 0.0f);
+
+		//distance from the camera, for ordering:
+		float distance = object.OBJECT_TO_CLIP[3].w;
+		min_distance = std::min(min_distance, distance);
+		max_distance = std::max(max_distance, distance);
+
+		//look up (or add) the material:
+		uint32_t material = -1U;
+		if (pipeline.material_block) {
+			uint64_t hash = 0xcbf29ce484222325ULL;
+			for (auto b : reinterpret_cast< uint8_t const (&)[sizeof(Material)] >(pipeline.material)) {
+				hash = (hash ^ b) * 0x100000001b3ULL;
+			}
+			auto f = draw_queue.material_hashes.find(hash);
+			if (f != draw_queue.material_hashes.end()
+			 && std::memcmp(&draw_queue.materials[f->second], &pipeline.material, sizeof(Material)) == 0) {
+				material = f->second;
+			} else {
+				//new (or, very rarely, colliding) material gets its own copy:
+				material = uint32_t(draw_queue.materials.size());
+				draw_queue.materials.emplace_back(pipeline.material);
+				draw_queue.material_hashes.emplace(hash, material);
+			}
+		}
 
-		//Set attribute sources:
-		glBindVertexArray(pipeline.vao);
+		draw_queue.drawables.emplace_back(&drawable);
+		draw_queue.distance.emplace_back(distance);
+		draw_queue.objects.emplace_back(object);
+		draw_queue.material.emplace_back(material);
+	}
 
-		//Configure program uniforms:
+	//key them by state, then depth:
+	float depth_scale = (max_distance > min_distance ? 1.0f / (max_distance - min_distance) : 0.0f);
+	for (uint32_t i = 0; i < draw_queue.drawables.size(); ++i) {
+		Scene::Drawable::Pipeline const &pipeline = draw_queue.drawables[i]->pipeline;
 
-		//the object-to-world matrix is used in all three of these uniforms:
-		assert(drawable.transform); //drawables *must* have a transform
-		glm::mat4x3 object_to_world = drawable.transform->make_local_to_world();
+		if (pipeline.keep_order) {
+			queue.push(RenderQueue::InOrderKey, i);
+			continue;
+		}
 
-		//OBJECT_TO_CLIP takes vertices from object space to clip space:
-		if (pipeline.OBJECT_TO_CLIP_mat4 != -1U) {
-			glm::mat4 object_to_clip = world_to_clip * glm::mat4(object_to_world);
-			glUniformMatrix4fv(pipeline.OBJECT_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(object_to_clip));
+		//texture sets are keyed by a hash of their (target, texture) pairs:
+		uint64_t textures = 0xcbf29ce484222325ULL;
+		for (uint32_t t = 0; t < Drawable::Pipeline::TextureCount; ++t) {
+			textures = (textures ^ pipeline.textures[t].texture) * 0x100000001b3ULL;
+			textures = (textures ^ (pipeline.textures[t].texture ? pipeline.textures[t].target : 0)) * 0x100000001b3ULL;
 		}
 
-		//the object-to-light matrix is used in the next two uniforms:
-		glm::mat4x3 object_to_light = world_to_light * glm::mat4(object_to_world);
+		queue.push(RenderQueue::make_key(
+			queue.program_ids(pipeline.program),
+			queue.vertex_array_ids(pipeline.vao),
+			queue.texture_ids(textures),
+			(draw_queue.distance[i] - min_distance) * depth_scale
+		), i);
+	}
+
+	queue.sort();
+}
 
-		//OBJECT_TO_CLIP takes vertices from object space to light space:
-		if (pipeline.OBJECT_TO_LIGHT_mat4x3 != -1U) {
-			glUniformMatrix4x3fv(pipeline.OBJECT_TO_LIGHT_mat4x3, 1, GL_FALSE, glm::value_ptr(object_to_light));
+//walk a sorted draw queue, letting 'cache' decide which state calls are needed and telling 'calls' about them:
+// (shared by draw() and count_state_calls(), so the counts are of exactly what draw() does)
+template< typename Calls >
+static void walk_draw_queue(Scene::DrawQueue const &draw_queue, RenderQueue::StateCache &cache, Calls &&calls) {
+	static_assert(RenderQueue::StateCache::TextureUnits == Scene::Drawable::Pipeline::TextureCount, "a cache binding per pipeline texture");
+
+	cache.stats.materials = uint32_t(draw_queue.materials.size());
+
+	//start from a known state, not whatever the caller left bound -- no program or vertex array,
+	// nothing on the texture targets the queue uses, TEXTURE0 active -- which is what a new 'cache' assumes:
+	std::vector< GLenum > targets;
+	for (auto const &item : draw_queue.queue.items) {
+		for (auto const &info : draw_queue.drawables[item.index]->pipeline.textures) {
+			if (info.texture != 0 && std::find(targets.begin(), targets.end(), info.target) == targets.end()) {
+				targets.emplace_back(info.target);
+			}
+		}
+	}
+	calls.use_program(0);
+	calls.bind_vertex_array(0);
+	cache.stats.programs += 1;
+	cache.stats.vertex_arrays += 1;
+	for (uint32_t i = 0; i < Scene::Drawable::Pipeline::TextureCount && !targets.empty(); ++i) {
+		calls.active_texture(i);
+		cache.stats.active_textures += 1;
+		for (GLenum target : targets) {
+			calls.bind_texture(target, 0);
+			cache.stats.textures += 1;
+		}
+	}
+	calls.active_texture(0);
+	cache.stats.active_textures += 1;
+	cache.active_unit = 0;
+
+	uint32_t unbind = 0;
+	for (auto const &item : draw_queue.queue.items) {
+		Scene::Drawable::Pipeline const &pipeline = draw_queue.drawables[item.index]->pipeline;
+
+		if (cache.use_program(pipeline.program)) calls.use_program(pipeline.program);
+		if (cache.bind_vertex_array(pipeline.vao)) calls.bind_vertex_array(pipeline.vao);
+
+		uint32_t texture_count = 0;
+		for (uint32_t i = 0; i < Scene::Drawable::Pipeline::TextureCount; ++i) {
+			Scene::Drawable::Pipeline::TextureInfo const &info = pipeline.textures[i];
+			if (info.texture != 0) texture_count += 1;
+			bool bind = cache.bind_texture(i, info.target, info.texture, &unbind);
+			if (!bind && !unbind) continue;
+			if (cache.active_texture(i)) calls.active_texture(i);
+			if (unbind) calls.bind_texture(unbind, 0);
+			if (bind) calls.bind_texture(info.target, info.texture);
 		}
 
-		//NORMAL_TO_CLIP takes normals from object space to light space:
-		if (pipeline.NORMAL_TO_LIGHT_mat3 != -1U) {
-			glm::mat3 normal_to_light = glm::inverse(glm::transpose(glm::mat3(object_to_light)));
-			glUniformMatrix3fv(pipeline.NORMAL_TO_LIGHT_mat3, 1, GL_FALSE, glm::value_ptr(normal_to_light));
+		//matrices, from the Object block or as separate uniforms:
+		if (pipeline.object_block) {
+			cache.stats.buffer_ranges += 1;
+			cache.stats.unbatched_uniforms += 3;
+			calls.bind_object(item.index);
+		} else {
+			uint32_t uniforms = (pipeline.OBJECT_TO_CLIP_mat4 != -1U)
+				+ (pipeline.OBJECT_TO_LIGHT_mat4x3 != -1U)
+				+ (pipeline.NORMAL_TO_LIGHT_mat3 != -1U);
+			cache.stats.uniforms += uniforms;
+			cache.stats.unbatched_uniforms += uniforms;
+			calls.set_matrices(item.index);
+		}
+		if (pipeline.material_block) {
+			uint32_t material = draw_queue.material[item.index];
+			if (cache.bind_material(material)) calls.bind_material(material);
 		}
+		if (pipeline.set_uniforms) cache.stats.set_uniforms += 1;
 
-		//set any requested custom uniforms:
-		if (pipeline.set_uniforms) pipeline.set_uniforms();
+		cache.stats.draws += 1;
+		cache.count_unsorted(texture_count);
+		calls.draw(item.index);
+	}
 
-		//set up textures:
-		for (uint32_t i = 0; i < Drawable::Pipeline::TextureCount; ++i) {
-			if (pipeline.textures[i].texture != 0) {
-				glActiveTexture(GL_TEXTURE0 + i);
-				glBindTexture(pipeline.textures[i].target, pipeline.textures[i].texture);
+	//leave things as the unsorted loop did -- no textures bound, TEXTURE0 active -- and unbind the rest:
+	for (uint32_t i = 0; i < Scene::Drawable::Pipeline::TextureCount; ++i) {
+		cache.bind_texture(i, 0, 0, &unbind);
+		if (!unbind) continue;
+		if (cache.active_texture(i)) calls.active_texture(i);
+		calls.bind_texture(unbind, 0);
+	}
+	if (cache.active_texture(0)) calls.active_texture(0);
+	if (cache.use_program(0)) calls.use_program(0);
+	if (cache.bind_vertex_array(0)) calls.bind_vertex_array(0);
+	cache.stats.unsorted_calls += 2;
+}
+
+RenderQueue::Stats Scene::count_state_calls(DrawQueue const &draw_queue) {
+	struct {
+		void use_program(GLuint) { }
+		void bind_vertex_array(GLuint) { }
+		void active_texture(uint32_t) { }
+		void bind_texture(GLenum, GLuint) { }
+		void bind_object(uint32_t) { }
+		void set_matrices(uint32_t) { }
+		void bind_material(uint32_t) { }
+		void draw(uint32_t) { }
+	} no_calls;
+	RenderQueue::StateCache cache;
+	walk_draw_queue(draw_queue, cache, no_calls);
+	return cache.stats;
+}
+
+void Scene::draw(glm::mat4 const &world_to_clip, glm::mat4x3 const &world_to_light, RenderQueue::Stats *stats) const {
+	DrawQueue &draw_queue = draw_state.draw_queue;
+	queue_drawables(world_to_clip, world_to_light, draw_queue);
+
+	//pack the Object blocks that programs will read, then the materials, into one uniform buffer:
+	StreamBuffer &uniform_buffer = draw_state.uniform_buffer;
+	std::vector< uint8_t > &uniform_data = draw_state.uniform_data;
+	std::vector< uint32_t > &object_offsets = draw_state.object_offsets;
+	if (uniform_buffer.buffer == 0) {
+		uniform_buffer.target = GL_UNIFORM_BUFFER;
+		uniform_buffer.alloc();
+		GLint align = 0;
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &align);
+		draw_state.alignment = GLuint(std::max(align, 1));
+	}
+	GLuint alignment = draw_state.alignment;
+	auto aligned = [alignment](size_t size) {
+		return uint32_t((size + alignment - 1) / alignment * alignment);
+	};
+
+	uniform_data.clear();
+	object_offsets.assign(draw_queue.objects.size(), -1U);
+	for (uint32_t i = 0; i < draw_queue.objects.size(); ++i) {
+		if (!draw_queue.drawables[i]->pipeline.object_block) continue;
+		object_offsets[i] = uint32_t(uniform_data.size());
+		uniform_data.resize(aligned(uniform_data.size() + sizeof(ObjectBlock)));
+		std::memcpy(uniform_data.data() + object_offsets[i], &draw_queue.objects[i], sizeof(ObjectBlock));
+	}
+	uint32_t materials_offset = uint32_t(uniform_data.size());
+	for (auto const &material : draw_queue.materials) {
+		size_t offset = uniform_data.size();
+		uniform_data.resize(aligned(offset + sizeof(Material)));
+		std::memcpy(uniform_data.data() + offset, &material, sizeof(Material));
+	}
+	uniform_buffer.upload(uniform_data.data(), uniform_data.size());
+
+	struct {
+		DrawQueue const &draw_queue;
+		GLuint uniform_buffer;
+		std::vector< uint32_t > const &object_offsets;
+		uint32_t materials_offset;
+		uint32_t material_stride;
+
+		void use_program(GLuint program) { glUseProgram(program); }
+		void bind_vertex_array(GLuint vao) { glBindVertexArray(vao); }
+		void active_texture(uint32_t unit) { glActiveTexture(GL_TEXTURE0 + unit); }
+		void bind_texture(GLenum target, GLuint texture) { glBindTexture(target, texture); }
+
+		void bind_object(uint32_t index) {
+			glBindBufferRange(GL_UNIFORM_BUFFER, ObjectBlockBinding, uniform_buffer, object_offsets[index], sizeof(ObjectBlock));
+		}
+		void bind_material(uint32_t material) {
+			glBindBufferRange(GL_UNIFORM_BUFFER, MaterialBlockBinding, uniform_buffer, materials_offset + material * material_stride, sizeof(Material));
+		}
+
+		//the slow path, for programs without the Object block:
+		void set_matrices(uint32_t index) {
+			Scene::Drawable::Pipeline const &pipeline = draw_queue.drawables[index]->pipeline;
+			ObjectBlock const &object = draw_queue.objects[index];
+			if (pipeline.OBJECT_TO_CLIP_mat4 != -1U) {
+				glUniformMatrix4fv(pipeline.OBJECT_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(object.OBJECT_TO_CLIP));
+			}
+			if (pipeline.OBJECT_TO_LIGHT_mat4x3 != -1U) {
+				glm::mat4x3 object_to_light(glm::vec3(object.OBJECT_TO_LIGHT[0]), glm::vec3(object.OBJECT_TO_LIGHT[1]), glm::vec3(object.OBJECT_TO_LIGHT[2]), glm::vec3(object.OBJECT_TO_LIGHT[3]));
+				glUniformMatrix4x3fv(pipeline.OBJECT_TO_LIGHT_mat4x3, 1, GL_FALSE, glm::value_ptr(object_to_light));
+			}
+			if (pipeline.NORMAL_TO_LIGHT_mat3 != -1U) {
+				glm::mat3 normal_to_light(glm::vec3(object.NORMAL_TO_LIGHT[0]), glm::vec3(object.NORMAL_TO_LIGHT[1]), glm::vec3(object.NORMAL_TO_LIGHT[2]));
+				glUniformMatrix3fv(pipeline.NORMAL_TO_LIGHT_mat3, 1, GL_FALSE, glm::value_ptr(normal_to_light));
 			}
 		}
 
-		//draw the object:
-		glDrawArrays(pipeline.type, pipeline.start, pipeline.count);
+		void draw(uint32_t index) {
+			Scene::Drawable::Pipeline const &pipeline = draw_queue.drawables[index]->pipeline;
 
-		//un-bind textures:
-		for (uint32_t i = 0; i < Drawable::Pipeline::TextureCount; ++i) {
-			if (pipeline.textures[i].texture != 0) {
-				glActiveTexture(GL_TEXTURE0 + i);
-				glBindTexture(pipeline.textures[i].target, 0);
-			}
+			//set any requested custom uniforms:
+			if (pipeline.set_uniforms) pipeline.set_uniforms();
+
+			//draw the object:
+			glDrawArrays(pipeline.type, pipeline.start, pipeline.count);
 		}
-		glActiveTexture(GL_TEXTURE0);
+	} gl_calls{draw_queue, uniform_buffer.buffer, object_offsets, materials_offset, aligned(sizeof(Material))};
 
-	}
+	RenderQueue::StateCache cache;
+	walk_draw_queue(draw_queue, cache, gl_calls);
+	cache.stats.uniform_bytes = uint32_t(uniform_data.size());
+	if (stats) *stats = cache.stats;
 
-	glUseProgram(0);
-	glBindVertexArray(0);
+	//don't hold on to drawable pointers until the next frame:
+	draw_queue.clear();
 
 	GL_ERRORS();
 }
 
+void Scene::release_draw_state() const {
+	draw_state.uniform_buffer.free();
+}
+
 
 void Scene::load(std::string const &filename,
 	std::function< void(Scene &, Transform *, std::string const &) > const &on_drawable) {
@@ -322,6 +569,10 @@ Scene::Scene(Scene const &other) {
 	set(other);
 }
 
+Scene::~Scene() {
+	release_draw_state();
+}
+
 Scene &Scene::operator=(Scene const &other) {
 	set(other);
 	return *this;
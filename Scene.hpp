@@ -11,6 +11,8 @@
  */
 
 #include "GL.hpp"
+#include "RenderQueue.hpp"
+#include "StreamBuffer.hpp"
 
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp>
@@ -49,6 +51,31 @@ struct Scene {
 		Transform() = default;
 	};
 
+	//Uniform blocks (std140 layout) that draw() fills from one uniform buffer per frame:
+	// programs that declare them should call bind_uniform_blocks() once after compiling
+	static constexpr GLuint ObjectBlockBinding = 0;
+	static constexpr GLuint MaterialBlockBinding = 1;
+
+	//per-drawable matrices:
+	// layout(std140) uniform Object { mat4 OBJECT_TO_CLIP; mat4x3 OBJECT_TO_LIGHT; mat3 NORMAL_TO_LIGHT; };
+	struct ObjectBlock {
+		glm::mat4 OBJECT_TO_CLIP;
+		glm::vec4 OBJECT_TO_LIGHT[4]; //(std140 pads mat4x3 and mat3 columns to vec4s)
+		glm::vec4 NORMAL_TO_LIGHT[3];
+	};
+	static_assert(sizeof(ObjectBlock) == 4*16 + 4*16 + 3*16, "ObjectBlock matches the std140 layout");
+
+	//parameters shared by drawables that look alike (drawables with equal materials share one copy):
+	// layout(std140) uniform Material { vec4 TINT; vec4 EMISSION; };
+	struct Material {
+		glm::vec4 TINT = glm::vec4(1.0f); //multiplies the (textured) color
+		glm::vec4 EMISSION = glm::vec4(0.0f); //added after lighting (.a unused)
+	};
+	static_assert(sizeof(Material) == 2*16, "Material matches the std140 layout");
+
+	//point 'program''s Object and Material blocks (whichever it has) at ObjectBlockBinding and MaterialBlockBinding:
+	static void bind_uniform_blocks(GLuint program);
+
 	struct Drawable {
 		//a 'Drawable' attaches attribute data to a transform:
 		Drawable(Transform *transform_) : transform(transform_) { assert(transform); }
@@ -65,12 +92,22 @@ struct Scene {
 			GLuint start = 0; //first vertex to draw; passed to glDrawArrays
 			GLuint count = 0; //number of vertices to draw; passed to glDrawArrays
 
+			//draw after all the sorted drawables, in list order (for drawables whose order matters, e.g. blended ones):
+			bool keep_order = false;
+
 			//uniforms:
 			GLuint OBJECT_TO_CLIP_mat4 = -1U; //uniform location for object to clip space matrix
 			GLuint OBJECT_TO_LIGHT_mat4x3 = -1U; //uniform location for object to light space (== world space) matrix
 			GLuint NORMAL_TO_LIGHT_mat3 = -1U; //uniform location for normal to light space (== world space) matrix
 
+			//uniform blocks:
+			bool object_block = false; //program gets the matrices from the Object block (the locations above go unused)
+			bool material_block = false; //program reads 'material' from the Material block
+			Material material;
+
 			std::function< void() > set_uniforms; //(optional) function to set any other useful uniforms
+			//  n.b. this is the slow path -- it is called before every draw of this drawable -- so prefer
+			//  putting shared parameters in 'material'
 
 			//texture objects to bind for the first TextureCount textures:
 			enum : uint32_t { TextureCount = 4 };
@@ -123,10 +160,47 @@ struct Scene {
 	std::list< Light > lights;
 
 	//The "draw" function provides a convenient way to pass all the things in a scene to OpenGL:
-	void draw(Camera const &camera) const;
+	// drawables are drawn sorted by state (program, then vertex array, then textures), then front-to-back --
+	// not in list order -- except 'keep_order' ones, which come last, in list order.
+	// state is only changed between drawables that need different state, starting from none bound
+	// (so a 'set_uniforms' function must leave the program, vertex array, and texture bindings alone)
+	// matrices (and materials) go to programs through the Object (and Material) blocks if their pipelines
+	// say so, or else one glUniform* call per matrix
+	// if 'stats' is given, it gets counts of the calls made (see RenderQueue.hpp)
+	void draw(Camera const &camera, RenderQueue::Stats *stats = nullptr) const;
 
 	//..sometimes, you want to draw with a custom projection matrix and/or light space:
-	void draw(glm::mat4 const &world_to_clip, glm::mat4x3 const &world_to_light = glm::mat4x3(1.0f)) const;
+	void draw(glm::mat4 const &world_to_clip, glm::mat4x3 const &world_to_light = glm::mat4x3(1.0f), RenderQueue::Stats *stats = nullptr) const;
+
+	//the drawables draw() will draw, in the order it will draw them:
+	struct DrawQueue {
+		RenderQueue queue; //sorted; items index the vectors below
+		std::vector< Drawable const * > drawables;
+		std::vector< float > distance; //clip-space w of the drawable's origin
+		std::vector< ObjectBlock > objects; //matrices
+		std::vector< uint32_t > material; //index in 'materials' (-1U if the pipeline has no material block)
+		std::vector< Material > materials; //without duplicates
+		std::unordered_map< uint64_t, uint32_t > material_hashes; //hash of a Material -> index in 'materials'
+		//empty everything (keeps allocations):
+		void clear();
+	};
+	void queue_drawables(glm::mat4 const &world_to_clip, glm::mat4x3 const &world_to_light, DrawQueue &draw_queue) const;
+	//count the calls drawing 'draw_queue' makes, without making them:
+	static RenderQueue::Stats count_state_calls(DrawQueue const &draw_queue);
+
+	//what draw() keeps between frames, so it doesn't re-allocate:
+	// (each scene has its own; copying a scene doesn't copy it)
+	struct DrawState {
+		DrawQueue draw_queue; //emptied after each draw, so it never points at removed drawables
+		StreamBuffer uniform_buffer; //Object blocks, then materials; made by the first draw()
+		std::vector< uint8_t > uniform_data; //uniform_buffer's contents
+		std::vector< uint32_t > object_offsets; //offset of each draw_queue.objects entry in uniform_data
+		GLuint alignment = 0; //GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+	};
+	mutable DrawState draw_state;
+	//free draw_state's GL buffer (the next draw() makes a new one); needs the GL context draw() ran in:
+	// (the destructor calls this, so release earlier if the scene outlives its context)
+	void release_draw_state() const;
 
 	//add transforms/objects/cameras from a scene file to this scene:
 	// the 'on_drawable' callback gives your code a chance to look up mesh data and make Drawables:
@@ -145,6 +219,8 @@ struct Scene {
 	//load a scene:
 	Scene(std::string const &filename, std::function< void(Scene &, Transform *, std::string const &) > const &on_drawable);
 
+	virtual ~Scene();
+
 	//copy a scene (with proper pointer fixup):
 	Scene(Scene const &); //...as a constructor
 	Scene &operator=(Scene const &); //...as scene = scene
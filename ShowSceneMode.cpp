@@ -68,6 +68,11 @@ bool ShowSceneMode::handle_event(SDL_Event const &evt, glm::uvec2 const &window_
 		if (camera.radius > 1e6f) camera.radius = 1e6f;
 		return true;
 	}
+	//F3: print draw stats
+	if (evt.type == SDL_KEYDOWN && evt.key.keysym.sym == SDLK_F3) {
+		report_stats = true;
+		return true;
+	}
 	
 	return false;
 }
@@ -91,7 +96,17 @@ void ShowSceneMode::draw(glm::uvec2 const &drawable_size) {
 	glEnable(GL_DEPTH_TEST);
 	glDepthFunc(GL_LEQUAL);
 
-	scene.draw(*scene_camera);
+	RenderQueue::Stats stats;
+	scene.draw(*scene_camera, &stats);
+	if (report_stats) {
+		report_stats = false;
+		std::cout << "Drew " << stats.draws << " drawables with " << stats.calls() << " state changes"
+			<< " (" << stats.programs << " programs, " << stats.vertex_arrays << " vertex arrays, "
+			<< stats.textures << " textures, " << stats.active_textures << " texture units);"
+			<< " drawing unsorted would take " << stats.unsorted_calls << "."
+			<< " Matrices + materials took " << stats.buffer_ranges << " buffer ranges (" << stats.uniform_bytes << " bytes) and "
+			<< stats.uniforms << " uniform calls, instead of " << stats.unbatched_uniforms << " uniform calls." << std::endl;
+	}
 
 	{ //decorate with some lines:
 		DrawLines draw_lines(scene_camera->make_projection() * glm::mat4(scene_camera->transform->make_world_to_local()));
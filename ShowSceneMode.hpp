@@ -33,4 +33,7 @@ struct ShowSceneMode : Mode {
 	//mode uses a secondary Scene to hold a camera:
 	Scene camera_scene;
 	Scene::Camera *scene_camera = nullptr;
+
+	//print Scene::draw's state change counts for the next frame (set by pressing F3):
+	bool report_stats = false;
 };
@@ -19,11 +19,15 @@ struct ShowSceneProgram {
 	GLuint Color_vec4 = -1U;
 	GLuint TexCoord_vec2 = -1U;
 
+	//Uniform blocks:
+	//Object - OBJECT_TO_CLIP, OBJECT_TO_LIGHT, NORMAL_TO_LIGHT (see Scene::ObjectBlock)
+
 	//Uniform (per-invocation variable) locations:
+	//the matrices are in the Object block, so these are -1 (kept so code that copies them into a
+	// Pipeline still works; Scene::draw only uses them when the pipeline has no Object block):
 	GLuint OBJECT_TO_CLIP_mat4 = -1U;
 	GLuint OBJECT_TO_LIGHT_mat4x3 = -1U;
 	GLuint NORMAL_TO_LIGHT_mat3 = -1U;
-
 	GLuint INSPECT_MODE_int = -1U; //0: basic lighting; 1: position only; 2: normal only; 3: color only; 4: texcoord only
 
 	//Textures:
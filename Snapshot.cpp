@@ -0,0 +1,38 @@
+#include "Snapshot.hpp"
+
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <cassert>
+
+bool Snapshot::parse(std::vector< char > &buffer, Snapshot *into) {
+	assert(into);
+	assert(!buffer.empty() && buffer[0] == 'a');
+	if (buffer.size() < 3) return false;
+	uint8_t count = uint8_t(buffer[1]);
+	if (count > MaxPlayers) {
+		throw std::runtime_error("Server sent a snapshot of " + std::to_string(count) + " players (more than the maximum).");
+	}
+	if (buffer.size() < 3 + 5 * size_t(count)) return false; //if whole message isn't here, can't process
+
+	auto short_from_buf = [&buffer](size_t start) {
+		uint16_t data = uint16_t(uint8_t(buffer[start + 1])) << 8 | uint16_t(uint8_t(buffer[start]));
+		return int16_t(data);
+	};
+
+	into->count = count;
+	into->color = uint8_t(buffer[2]);
+	for (uint8_t i = 0; i < count; ++i) {
+		size_t offset = 3 + size_t(i) * 5;
+		into->entries[i].state = uint8_t(buffer[offset]);
+		into->entries[i].x = short_from_buf(offset + 1);
+		into->entries[i].y = short_from_buf(offset + 3);
+	}
+
+	buffer.erase(buffer.begin(), buffer.begin() + 3 + 5 * size_t(count));
+	return true;
+}
+
+double Snapshot::now() {
+	return std::chrono::duration< double >(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
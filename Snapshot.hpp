@@ -0,0 +1,35 @@
+#pragma once
+
+/*
+ * Snapshot is a parsed copy of the server's 'a' (game state) message:
+ *
+ *  'a' + count + own color + count * (state byte + 2-byte x + 2-byte y)
+ *
+ * where the state byte packs it / airborne / sliding left / sliding right
+ * into the top four bits and the player's color into the bottom three.
+ */
+
+#include <vector>
+#include <cstdint>
+
+struct Snapshot {
+	static constexpr uint8_t MaxPlayers = 8;
+
+	uint8_t color = 0; //color of the receiving client's own player
+	uint8_t count = 0; //number of valid entries
+	struct Entry {
+		uint8_t state = 0;
+		int16_t x = 0;
+		int16_t y = 0;
+	} entries[MaxPlayers];
+
+	double arrival = 0.0; //local steady-clock time (seconds) at which the message was received
+
+	//parse an 'a' message from the front of 'buffer' and erase it:
+	// returns false (and leaves 'buffer' alone) if the whole message hasn't arrived yet.
+	// throws if the message is malformed.
+	static bool parse(std::vector< char > &buffer, Snapshot *into);
+
+	//seconds on the steady clock, for stamping 'arrival':
+	static double now();
+};
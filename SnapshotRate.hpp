@@ -0,0 +1,69 @@
+#pragma once
+
+/*
+ * SnapshotRate picks how often the server sends game state to one client.
+ *
+ * The rate grows additively while the connection keeps up and is halved
+ * whenever snapshots start queueing up faster than the socket drains them
+ * (AIMD, as in TCP congestion control). It is also capped by the client's
+ * round-trip time: a client that sees the world ~RTT late gains little from
+ * updates much more often than that.
+ *
+ * Clients interpolate between snapshots, drawing other players
+ * InterpIntervals snapshot intervals in the past.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+struct SnapshotRate {
+	static constexpr float MinRate = 10.0f; //Hz
+	static constexpr float RateStep = 2.0f; //Hz added per snapshot that drains in time
+	static constexpr float RttFraction = 1.0f / 8.0f; //cap rate at one snapshot per this fraction of the RTT
+	static constexpr float InterpIntervals = 1.5f; //how many snapshot intervals behind clients draw others
+
+	SnapshotRate(float max_rate_) : max_rate(max_rate_), rate(max_rate_) { }
+
+	float max_rate; //Hz (generally the server tick rate)
+	float rate; //Hz, current choice
+
+	//call once per server tick (of length 'tick' seconds) for each client, *before* queueing anything for it;
+	// 'backlog' is the client's send_buffer size, 'bytes_sent' its running total of bytes sent.
+	//returns true if a snapshot should be sent this tick:
+	bool due(double now, float tick, size_t backlog, uint64_t bytes_sent, float rtt) {
+		//how fast has this connection actually been draining?
+		float drained = float(bytes_sent - last_bytes_sent) / tick;
+		last_bytes_sent = bytes_sent;
+		drain_rate += 0.1f * (drained - drain_rate);
+
+		if (now < next_send) return false;
+
+		float cap = max_rate;
+		if (rtt * RttFraction > 1.0f / cap) cap = 1.0f / (rtt * RttFraction);
+		cap = std::max(MinRate, cap);
+
+		//backpressure: would what's still queued take longer than an interval to drain?
+		if (backlog > 0 && (drain_rate <= 0.0f || float(backlog) / drain_rate > 1.0f / rate)) {
+			rate *= 0.5f;
+		} else {
+			rate += RateStep;
+		}
+		rate = std::max(MinRate, std::min(cap, rate));
+
+		//accumulate (rather than reset from 'now') so a rate of exactly max_rate lines up with ticks:
+		next_send += 1.0 / rate;
+		if (next_send < now) next_send = now;
+		return true;
+	}
+
+	//how far behind the newest snapshot the client is expected to draw others (seconds):
+	float interp_delay() const {
+		return InterpIntervals / rate;
+	}
+
+	//internals:
+	double next_send = 0.0;
+	uint64_t last_bytes_sent = 0;
+	float drain_rate = 0.0f; //bytes per second, smoothed
+};
@@ -0,0 +1,140 @@
+#include "SpriteBatch.hpp"
+
+#include "ColorTextureProgram.hpp"
+#include "gl_errors.hpp"
+
+#include <glm/gtc/type_ptr.hpp>
+
+GLuint make_sprite_vertex_array(GLuint buffer) {
+	GLuint vertex_array = 0;
+	//ask OpenGL to fill vertex_array with the name of an unused vertex array object:
+	glGenVertexArrays(1, &vertex_array);
+
+	//set vertex_array as the current vertex array object:
+	glBindVertexArray(vertex_array);
+
+	//set buffer as the source of glVertexAttribPointer() commands:
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+
+	//set up the vertex array object to describe arrays of SpriteVertex:
+	glVertexAttribPointer(
+		color_texture_program->Position_vec4, //attribute
+		3, //size
+		GL_FLOAT, //type
+		GL_FALSE, //normalized
+		sizeof(SpriteVertex), //stride
+		(GLbyte *)0 + offsetof(SpriteVertex, Position) //offset
+	);
+	glEnableVertexAttribArray(color_texture_program->Position_vec4);
+	//[Note that it is okay to bind a vec3 input to a vec4 attribute -- the w component will be filled with 1.0 automatically]
+
+	glVertexAttribPointer(
+		color_texture_program->Color_vec4, //attribute
+		4, //size
+		GL_UNSIGNED_BYTE, //type
+		GL_TRUE, //normalized
+		sizeof(SpriteVertex), //stride
+		(GLbyte *)0 + offsetof(SpriteVertex, Color) //offset
+	);
+	glEnableVertexAttribArray(color_texture_program->Color_vec4);
+
+	glVertexAttribPointer(
+		color_texture_program->TexCoord_vec2, //attribute
+		2, //size
+		GL_FLOAT, //type
+		GL_FALSE, //normalized
+		sizeof(SpriteVertex), //stride
+		(GLbyte *)0 + offsetof(SpriteVertex, TexCoord) //offset
+	);
+	glEnableVertexAttribArray(color_texture_program->TexCoord_vec2);
+
+	//done referring to buffer, so unbind it:
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	//done setting up vertex array object, so unbind it:
+	glBindVertexArray(0);
+
+	GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
+
+	return vertex_array;
+}
+
+SpriteBatch::SpriteBatch() {
+	vertex_buffer.alloc();
+	vertex_buffer_for_color_texture_program = make_sprite_vertex_array(vertex_buffer.buffer);
+}
+
+SpriteBatch::~SpriteBatch() {
+	glDeleteVertexArrays(1, &vertex_buffer_for_color_texture_program);
+	vertex_buffer_for_color_texture_program = 0;
+	vertex_buffer.free();
+}
+
+void SpriteBatch::begin(glm::mat4 const &object_to_clip_) {
+	object_to_clip = object_to_clip_;
+	stats = Stats();
+	//drop anything left over from a frame that never flushed:
+	vertices.clear();
+	batches.clear();
+	batch_start = 0;
+	texture = 0;
+}
+
+void SpriteBatch::set_texture(GLuint texture_) {
+	if (texture_ == texture) return;
+	close_batch();
+	texture = texture_;
+}
+
+void SpriteBatch::close_batch() {
+	if (vertices.size() == batch_start) return;
+	GLsizei count = GLsizei(vertices.size() - batch_start);
+	if (!batches.empty() && batches.back().texture == texture
+	 && size_t(batches.back().first + batches.back().count) == batch_start) {
+		//same texture as the run just before (e.g. A, empty B, A): keep it one draw call
+		batches.back().count += count;
+	} else {
+		batches.emplace_back(Batch{texture, GLint(batch_start), count});
+	}
+	batch_start = vertices.size();
+}
+
+void SpriteBatch::flush() {
+	close_batch();
+	if (vertices.empty()) return;
+
+	//upload all batches at once:
+	vertex_buffer.upload(vertices.data(), vertices.size() * sizeof(vertices[0]));
+
+	//set color_texture_program as current program:
+	glUseProgram(color_texture_program->program);
+
+	//upload OBJECT_TO_CLIP to the proper uniform location:
+	glUniformMatrix4fv(color_texture_program->OBJECT_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(object_to_clip));
+
+	//use the mapping vertex_buffer_for_color_texture_program to fetch vertex data:
+	glBindVertexArray(vertex_buffer_for_color_texture_program);
+
+	glActiveTexture(GL_TEXTURE0);
+	for (auto const &batch : batches) {
+		glBindTexture(GL_TEXTURE_2D, batch.texture);
+		glDrawArrays(GL_TRIANGLES, batch.first, batch.count);
+	}
+
+	//reset texture, vertex array, and program to none:
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glBindVertexArray(0);
+	glUseProgram(0);
+
+	GL_ERRORS();
+
+	stats.quads += uint32_t(vertices.size() / 6);
+	stats.batches += uint32_t(batches.size());
+	stats.flushes += 1;
+	stats.bytes_uploaded += vertices.size() * sizeof(vertices[0]);
+
+	//keep the storage for the next frame:
+	vertices.clear();
+	batches.clear();
+	batch_start = 0;
+}
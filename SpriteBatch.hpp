@@ -0,0 +1,82 @@
+#pragma once
+
+/*
+ * SpriteBatch collects textured quads (as SpriteVertex triangles) for
+ * color_texture_program and draws them with one upload per flush().
+ *
+ * Usage, each frame:
+ *   batch.begin(object_to_clip);
+ *   batch.set_texture(tex);
+ *   append_sprite(batch.vertices, ...); //or push SpriteVertex triangles directly
+ *   batch.set_texture(other_tex); //starts a new batch (one glDrawArrays each)
+ *   ...
+ *   batch.flush();
+ *
+ * Vertex and batch storage is kept between frames, so once it has grown to
+ * a frame's worth of sprites there are no more allocations.
+ *
+ * Needs a current OpenGL context (and color_texture_program loaded) to construct.
+ *
+ * PlayMode doesn't use it at the moment: the level is drawn from buffers built
+ * once, and players + text are drawn as instances (SpriteInstanceBatch). It is
+ * kept for sprites the instanced path can't draw (rotated ones, say); PlayMode
+ * does use make_sprite_vertex_array for the level buffer.
+ */
+
+#include "LevelGeometry.hpp"
+#include "StreamBuffer.hpp"
+
+#include "GL.hpp"
+#include <glm/glm.hpp>
+
+#include <vector>
+
+//vertex array object describing a buffer of SpriteVertex for color_texture_program:
+GLuint make_sprite_vertex_array(GLuint buffer);
+
+struct SpriteBatch {
+	SpriteBatch();
+	~SpriteBatch();
+	SpriteBatch(SpriteBatch const &) = delete;
+	SpriteBatch &operator=(SpriteBatch const &) = delete;
+
+	//start collecting sprites for a new frame (resets stats):
+	void begin(glm::mat4 const &object_to_clip);
+
+	//sprites appended after this call sample 'texture' (bound to TEXTURE0):
+	void set_texture(GLuint texture);
+
+	//sprites not yet drawn; append two CCW triangles per quad:
+	std::vector< SpriteVertex > vertices;
+
+	//upload everything appended since the last flush() and draw it (one glDrawArrays per batch):
+	// (uses the caller's blend / depth state)
+	void flush();
+
+	//----- counters -----
+	struct Stats {
+		uint32_t quads = 0; //sprites drawn
+		uint32_t batches = 0; //draw calls issued
+		uint32_t flushes = 0; //uploads
+		uint64_t bytes_uploaded = 0;
+	};
+	Stats stats; //since begin()
+
+	//----- internals -----
+	glm::mat4 object_to_clip = glm::mat4(1.0f);
+
+	//a run of vertices that share a texture:
+	struct Batch {
+		GLuint texture;
+		GLint first;
+		GLsizei count;
+	};
+	std::vector< Batch > batches;
+	GLuint texture = 0; //texture for vertices past batch_start
+	size_t batch_start = 0;
+	//move vertices past batch_start into batches:
+	void close_batch();
+
+	StreamBuffer vertex_buffer;
+	GLuint vertex_buffer_for_color_texture_program = 0;
+};
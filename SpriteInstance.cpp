@@ -0,0 +1,25 @@
+#include "SpriteInstance.hpp"
+
+#include "Level.hpp"
+
+#include <stdexcept>
+#include <string>
+
+uint16_t SpriteFrames::add(glm::vec2 tex, glm::vec2 tex_size) {
+	if (rects.size() >= MaxFrames) {
+		throw std::runtime_error("SpriteFrames holds at most " + std::to_string(MaxFrames) + " frames.");
+	}
+	rects.emplace_back(tex.x, tex.y, tex_size.x, tex_size.y);
+	return uint16_t(rects.size() - 1);
+}
+
+uint16_t SpriteFrames::add_tiles(glm::vec2 tilepos, glm::vec2 tilesize, glm::vec2 tileset_size) {
+	return add(
+		glm::vec2(tilepos.x * Level::TileSize / tileset_size.x, tilepos.y * Level::TileSize / tileset_size.y),
+		glm::vec2(tilesize.x * Level::TileSize / tileset_size.x, tilesize.y * Level::TileSize / tileset_size.y)
+	);
+}
+
+uint16_t SpriteFrames::add(Atlas::Sprite const &sprite) {
+	return add(sprite.tex, sprite.tex_size);
+}
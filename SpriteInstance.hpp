@@ -0,0 +1,64 @@
+#pragma once
+
+/*
+ * Per-sprite record for instanced drawing with SpriteInstanceProgram.
+ *
+ * A SpriteVertex sprite is six 24-byte vertices (144 bytes); a SpriteInstance
+ * sprite is one 16-byte record, expanded from a shared unit quad on the GPU.
+ * Instead of texture coordinates, each instance names a 'frame' -- an entry in
+ * a small table of texture rectangles (SpriteFrames) uploaded as a uniform array.
+ *
+ * It doesn't depend on OpenGL, so packing can be benchmarked headless
+ * (see bench-instances.cpp); SpriteInstanceBatch draws them.
+ */
+
+#include "Atlas.hpp"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+struct SpriteInstance {
+	//positions are stored in steps of 1 / PositionScale pixels (so, about +/- 8191 pixels of range):
+	static constexpr float PositionScale = 4.0f;
+
+	SpriteInstance() { } //uninitialized (so storage can be resize()'d and filled in place)
+	//pos (lower corner), size are in pixels; frame is an index into SpriteFrames::rects:
+	SpriteInstance(glm::vec2 pos_, glm::vec2 size_, uint16_t frame_, glm::u8vec4 const &color_) :
+		pos(quantize_position(pos_.x), quantize_position(pos_.y)),
+		size(quantize_size(size_.x), quantize_size(size_.y)),
+		frame(frame_), color(color_) { }
+
+	glm::i16vec2 pos;
+	glm::u16vec2 size;
+	uint16_t frame;
+	uint16_t unused = 0; //(pads color to four-byte alignment)
+	glm::u8vec4 color;
+
+	static int16_t quantize_position(float p) {
+		return int16_t(std::max(-32768.0f, std::min(32767.0f, std::round(p * PositionScale))));
+	}
+	static uint16_t quantize_size(float s) {
+		return uint16_t(std::max(0.0f, std::min(65535.0f, std::round(s))));
+	}
+};
+static_assert(sizeof(SpriteInstance) == 16, "SpriteInstance should be packed");
+
+//texture rectangles instances can refer to:
+struct SpriteFrames {
+	//(size of the FRAMES array in SpriteInstanceProgram)
+	static constexpr uint32_t MaxFrames = 64;
+
+	//add a frame covering [tex, tex + tex_size] (texture coordinates); returns its index:
+	// throws if there are already MaxFrames frames
+	uint16_t add(glm::vec2 tex, glm::vec2 tex_size);
+	//add a frame given in tileset tiles (Level::TileSize pixels each), as append_sprite takes them:
+	uint16_t add_tiles(glm::vec2 tilepos, glm::vec2 tilesize, glm::vec2 tileset_size);
+	//add a frame for a sprite packed by atlas_packer (draw with the atlas texture bound):
+	uint16_t add(Atlas::Sprite const &sprite);
+
+	std::vector< glm::vec4 > rects; //(x, y, width, height) in texture coordinates
+};
@@ -0,0 +1,142 @@
+#include "SpriteInstanceBatch.hpp"
+
+#include "SpriteInstanceProgram.hpp"
+#include "gl_errors.hpp"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <cassert>
+
+SpriteInstanceBatch::SpriteInstanceBatch() {
+	{ //unit quad corners, drawn as a triangle strip:
+		glm::vec2 corners[4] = {
+			glm::vec2(0.0f, 0.0f),
+			glm::vec2(1.0f, 0.0f),
+			glm::vec2(0.0f, 1.0f),
+			glm::vec2(1.0f, 1.0f),
+		};
+		glGenBuffers(1, &corner_buffer);
+		glBindBuffer(GL_ARRAY_BUFFER, corner_buffer);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	instance_buffer.alloc();
+
+	{ //vertex array mapping corner_buffer + instance_buffer for sprite_instance_program:
+		glGenVertexArrays(1, &vertex_array);
+		glBindVertexArray(vertex_array);
+
+		//per-vertex:
+		glBindBuffer(GL_ARRAY_BUFFER, corner_buffer);
+		glVertexAttribPointer(
+			sprite_instance_program->Corner_vec2, //attribute
+			2, //size
+			GL_FLOAT, //type
+			GL_FALSE, //normalized
+			sizeof(glm::vec2), //stride
+			(GLbyte *)0 //offset
+		);
+		glEnableVertexAttribArray(sprite_instance_program->Corner_vec2);
+
+		//per-instance (divisor 1 -- advance once per instance):
+		glBindBuffer(GL_ARRAY_BUFFER, instance_buffer.buffer);
+		glVertexAttribPointer(
+			sprite_instance_program->Position_vec2, //attribute
+			2, //size
+			GL_SHORT, //type
+			GL_FALSE, //normalized [so values arrive as-is, in 1/PositionScale pixel steps]
+			sizeof(SpriteInstance), //stride
+			(GLbyte *)0 + offsetof(SpriteInstance, pos) //offset
+		);
+		glEnableVertexAttribArray(sprite_instance_program->Position_vec2);
+		glVertexAttribDivisor(sprite_instance_program->Position_vec2, 1);
+
+		glVertexAttribPointer(
+			sprite_instance_program->Size_vec2, //attribute
+			2, //size
+			GL_UNSIGNED_SHORT, //type
+			GL_FALSE, //normalized
+			sizeof(SpriteInstance), //stride
+			(GLbyte *)0 + offsetof(SpriteInstance, size) //offset
+		);
+		glEnableVertexAttribArray(sprite_instance_program->Size_vec2);
+		glVertexAttribDivisor(sprite_instance_program->Size_vec2, 1);
+
+		//(integer attribute, so glVertexAttribIPointer:)
+		glVertexAttribIPointer(
+			sprite_instance_program->Frame_uint, //attribute
+			1, //size
+			GL_UNSIGNED_SHORT, //type
+			sizeof(SpriteInstance), //stride
+			(GLbyte *)0 + offsetof(SpriteInstance, frame) //offset
+		);
+		glEnableVertexAttribArray(sprite_instance_program->Frame_uint);
+		glVertexAttribDivisor(sprite_instance_program->Frame_uint, 1);
+
+		glVertexAttribPointer(
+			sprite_instance_program->Color_vec4, //attribute
+			4, //size
+			GL_UNSIGNED_BYTE, //type
+			GL_TRUE, //normalized
+			sizeof(SpriteInstance), //stride
+			(GLbyte *)0 + offsetof(SpriteInstance, color) //offset
+		);
+		glEnableVertexAttribArray(sprite_instance_program->Color_vec4);
+		glVertexAttribDivisor(sprite_instance_program->Color_vec4, 1);
+
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glBindVertexArray(0);
+	}
+
+	GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
+}
+
+SpriteInstanceBatch::~SpriteInstanceBatch() {
+	glDeleteVertexArrays(1, &vertex_array);
+	vertex_array = 0;
+	glDeleteBuffers(1, &corner_buffer);
+	corner_buffer = 0;
+	instance_buffer.free();
+}
+
+void SpriteInstanceBatch::begin(glm::mat4 const &object_to_clip_) {
+	object_to_clip = object_to_clip_;
+	stats = Stats();
+	instances.clear();
+}
+
+void SpriteInstanceBatch::flush() {
+	if (instances.empty()) return;
+	assert(frames.rects.size() <= SpriteFrames::MaxFrames);
+
+	instance_buffer.upload(instances.data(), instances.size() * sizeof(instances[0]));
+
+	glUseProgram(sprite_instance_program->program);
+
+	glUniformMatrix4fv(sprite_instance_program->OBJECT_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(object_to_clip));
+	//(the frame table is program state shared by every batch, so it goes up with each flush; it's small)
+	if (!frames.rects.empty()) {
+		glUniform4fv(sprite_instance_program->FRAMES_vec4_array, GLsizei(frames.rects.size()), glm::value_ptr(frames.rects[0]));
+	}
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, texture);
+
+	glBindVertexArray(vertex_array);
+	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, GLsizei(instances.size()));
+
+	//reset texture, vertex array, and program to none:
+	glBindVertexArray(0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glUseProgram(0);
+
+	GL_ERRORS();
+
+	stats.sprites += uint32_t(instances.size());
+	stats.flushes += 1;
+	stats.bytes_uploaded += instances.size() * sizeof(instances[0]) + frames.rects.size() * sizeof(frames.rects[0]);
+
+	//keep the storage for the next frame:
+	instances.clear();
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+/*
+ * SpriteInstanceBatch collects SpriteInstances that share one texture and
+ * frame table, and draws them with a single glDrawArraysInstanced per flush().
+ *
+ * Usage:
+ *   //once:
+ *   batch.texture = tex;
+ *   uint16_t frame = batch.frames.add(...);
+ *   //each frame:
+ *   batch.begin(object_to_clip);
+ *   batch.instances.emplace_back(pos, size, frame, color);
+ *   batch.flush();
+ *
+ * Like SpriteBatch, storage is kept between frames and uploads go through
+ * an orphaning StreamBuffer. (Sprites it can't draw -- rotated ones, or ones
+ * from another texture -- go through SpriteBatch.)
+ *
+ * Needs a current OpenGL context (and sprite_instance_program loaded) to construct.
+ */
+
+#include "SpriteInstance.hpp"
+#include "StreamBuffer.hpp"
+
+#include "GL.hpp"
+#include <glm/glm.hpp>
+
+#include <vector>
+
+struct SpriteInstanceBatch {
+	SpriteInstanceBatch();
+	~SpriteInstanceBatch();
+	SpriteInstanceBatch(SpriteInstanceBatch const &) = delete;
+	SpriteInstanceBatch &operator=(SpriteInstanceBatch const &) = delete;
+
+	//texture and frame table used by every instance:
+	GLuint texture = 0;
+	SpriteFrames frames;
+
+	//start collecting instances for a new frame (resets stats):
+	void begin(glm::mat4 const &object_to_clip);
+
+	//instances not yet drawn:
+	std::vector< SpriteInstance > instances;
+
+	//upload everything added since the last flush() and draw it:
+	// (uses the caller's blend / depth state)
+	void flush();
+
+	//----- counters -----
+	struct Stats {
+		uint32_t sprites = 0; //instances drawn
+		uint32_t flushes = 0; //draw calls issued
+		uint64_t bytes_uploaded = 0; //instances + frame table
+	};
+	Stats stats; //since begin()
+
+	//----- internals -----
+	glm::mat4 object_to_clip = glm::mat4(1.0f);
+
+	GLuint corner_buffer = 0; //unit quad, as a triangle strip
+	StreamBuffer instance_buffer;
+	GLuint vertex_array = 0; //corner_buffer per vertex + instance_buffer per instance, for sprite_instance_program
+};
@@ -0,0 +1,69 @@
+#include "SpriteInstanceProgram.hpp"
+
+#include "SpriteInstance.hpp"
+#include "gl_compile_program.hpp"
+#include "gl_errors.hpp"
+
+#include <string>
+
+Load< SpriteInstanceProgram > sprite_instance_program(LoadTagEarly);
+
+SpriteInstanceProgram::SpriteInstanceProgram() {
+	//Compile vertex and fragment shaders using the convenient 'gl_compile_program' helper function:
+	program = gl_compile_program(
+		//vertex shader:
+		"#version 330\n"
+		"uniform mat4 OBJECT_TO_CLIP;\n"
+		"uniform vec4 FRAMES[" + std::to_string(SpriteFrames::MaxFrames) + "];\n"
+		"in vec2 Corner;\n"
+		"in vec2 Position;\n"
+		"in vec2 Size;\n"
+		"in uint Frame;\n"
+		"in vec4 Color;\n"
+		"out vec4 color;\n"
+		"out vec2 texCoord;\n"
+		"void main() {\n"
+		"	vec2 at = Position * " + std::to_string(1.0f / SpriteInstance::PositionScale) + " + Corner * Size;\n"
+		"	gl_Position = OBJECT_TO_CLIP * vec4(at, 0.0, 1.0);\n"
+		"	vec4 frame = FRAMES[Frame];\n"
+		"	texCoord = frame.xy + Corner * frame.zw;\n"
+		"	color = Color;\n"
+		"}\n"
+	,
+		//fragment shader:
+		"#version 330\n"
+		"uniform sampler2D TEX;\n"
+		"in vec4 color;\n"
+		"in vec2 texCoord;\n"
+		"out vec4 fragColor;\n"
+		"void main() {\n"
+		"	fragColor = texture(TEX, texCoord) * color;\n"
+		"}\n"
+	);
+
+	//look up the locations of vertex attributes:
+	Corner_vec2 = glGetAttribLocation(program, "Corner");
+	Position_vec2 = glGetAttribLocation(program, "Position");
+	Size_vec2 = glGetAttribLocation(program, "Size");
+	Frame_uint = glGetAttribLocation(program, "Frame");
+	Color_vec4 = glGetAttribLocation(program, "Color");
+
+	//look up the locations of uniforms:
+	OBJECT_TO_CLIP_mat4 = glGetUniformLocation(program, "OBJECT_TO_CLIP");
+	FRAMES_vec4_array = glGetUniformLocation(program, "FRAMES");
+	GLuint TEX_sampler2D = glGetUniformLocation(program, "TEX");
+
+	//set TEX to always refer to texture binding zero:
+	glUseProgram(program); //bind program -- glUniform* calls refer to this program now
+
+	glUniform1i(TEX_sampler2D, 0); //set TEX to sample from GL_TEXTURE0
+
+	glUseProgram(0); //unbind program -- glUniform* calls refer to ??? now
+
+	GL_ERRORS();
+}
+
+SpriteInstanceProgram::~SpriteInstanceProgram() {
+	glDeleteProgram(program);
+	program = 0;
+}
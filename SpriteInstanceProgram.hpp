@@ -0,0 +1,28 @@
+#pragma once
+
+#include "GL.hpp"
+#include "Load.hpp"
+
+//Shader program that draws instanced sprites (see SpriteInstance.hpp):
+// each instance stretches a unit quad to its position + size and
+// textures it with one entry of the FRAMES table, tinted by its color.
+struct SpriteInstanceProgram {
+	SpriteInstanceProgram();
+	~SpriteInstanceProgram();
+
+	GLuint program = 0;
+	//Attribute (per-vertex variable) locations:
+	GLuint Corner_vec2 = -1U; //unit quad corner, (0,0) - (1,1)
+	//Attribute (per-instance variable) locations:
+	GLuint Position_vec2 = -1U; //lower corner, in 1 / SpriteInstance::PositionScale pixel steps
+	GLuint Size_vec2 = -1U;
+	GLuint Frame_uint = -1U;
+	GLuint Color_vec4 = -1U;
+	//Uniform (per-invocation variable) locations:
+	GLuint OBJECT_TO_CLIP_mat4 = -1U;
+	GLuint FRAMES_vec4_array = -1U; //SpriteFrames::MaxFrames entries of (x, y, width, height)
+	//Textures:
+	//TEXTURE0 - texture that is accessed through FRAMES
+};
+
+extern Load< SpriteInstanceProgram > sprite_instance_program;
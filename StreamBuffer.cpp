@@ -0,0 +1,41 @@
+#include "StreamBuffer.hpp"
+
+#include "gl_errors.hpp"
+
+#include <cassert>
+
+void StreamBuffer::alloc() {
+	assert(buffer == 0 && "StreamBuffer::alloc() called twice");
+	glGenBuffers(1, &buffer);
+	capacity = 0;
+	GL_ERRORS();
+}
+
+void StreamBuffer::free() {
+	if (buffer != 0) {
+		glDeleteBuffers(1, &buffer);
+		buffer = 0;
+	}
+	capacity = 0;
+}
+
+void StreamBuffer::upload(void const *data, size_t size) {
+	assert(buffer != 0 && "StreamBuffer::upload() before alloc()");
+	if (size == 0) return;
+
+	//grow to a power of two so a slowly increasing size doesn't reallocate every frame:
+	if (GLsizeiptr(size) > capacity) {
+		GLsizeiptr new_capacity = (capacity > 0 ? capacity : 4096);
+		while (new_capacity < GLsizeiptr(size)) new_capacity *= 2;
+		capacity = new_capacity;
+	}
+
+	glBindBuffer(target, buffer);
+	//orphan the old storage (a draw may still be reading it), then fill the front of the new storage:
+	glBufferData(target, capacity, nullptr, GL_STREAM_DRAW);
+	glBufferSubData(target, 0, GLsizeiptr(size), data);
+	glBindBuffer(target, 0);
+
+	uploads += 1;
+	bytes_uploaded += size;
+}
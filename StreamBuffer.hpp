@@ -0,0 +1,36 @@
+#pragma once
+
+/*
+ * A GL buffer (GL_ARRAY_BUFFER, unless 'target' says otherwise) whose contents are
+ * replaced every frame (or more often).
+ *
+ * Each upload() orphans the buffer's old storage before writing, so the driver
+ * can hand back fresh memory instead of waiting for draws still reading the
+ * previous contents. Storage only grows (to a power of two), so steady-state
+ * uploads don't reallocate.
+ *
+ * Used by SpriteBatch, DrawLines, and (as a GL_UNIFORM_BUFFER) Scene::draw.
+ */
+
+#include "GL.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+struct StreamBuffer {
+	//create the GL buffer (needs a current OpenGL context):
+	void alloc();
+	//delete the GL buffer:
+	void free();
+
+	//replace the buffer's contents with bytes [data, data + size):
+	void upload(void const *data, size_t size);
+
+	GLenum target = GL_ARRAY_BUFFER; //binding point used while uploading
+	GLuint buffer = 0;
+	GLsizeiptr capacity = 0; //bytes of storage allocated for buffer
+
+	//running totals:
+	uint64_t uploads = 0;
+	uint64_t bytes_uploaded = 0;
+};
@@ -0,0 +1,102 @@
+#include "TilemapLayer.hpp"
+
+#include "TilemapProgram.hpp"
+#include "gl_errors.hpp"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <cassert>
+
+TilemapLayer::TilemapLayer(LevelGeometry const &geometry) : width(geometry.width), height(geometry.height) {
+	{ //cells texture:
+		std::vector< glm::u8vec2 > cells;
+		geometry.build_cells(cells);
+
+		glGenTextures(1, &cells_tex);
+		glBindTexture(GL_TEXTURE_2D, cells_tex);
+		//(rows of two-byte texels may not be four-byte aligned)
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RG8UI, GLsizei(width), GLsizei(height), 0, GL_RG_INTEGER, GL_UNSIGNED_BYTE, cells.data());
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		//integer textures can't be filtered:
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+
+	{ //one quad (two triangles) over the whole level:
+		glm::vec2 size = glm::vec2(float(width), float(height)) * Level::TileSize;
+		glm::vec2 corners[6] = {
+			glm::vec2(0.0f, 0.0f), glm::vec2(size.x, 0.0f), glm::vec2(size.x, size.y),
+			glm::vec2(0.0f, 0.0f), glm::vec2(size.x, size.y), glm::vec2(0.0f, size.y),
+		};
+		glGenBuffers(1, &quad_buffer);
+		glBindBuffer(GL_ARRAY_BUFFER, quad_buffer);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+
+		glGenVertexArrays(1, &quad_buffer_for_tilemap_program);
+		glBindVertexArray(quad_buffer_for_tilemap_program);
+		glVertexAttribPointer(
+			tilemap_program->Position_vec4, //attribute
+			2, //size
+			GL_FLOAT, //type
+			GL_FALSE, //normalized
+			sizeof(glm::vec2), //stride
+			(GLbyte *)0 //offset
+		);
+		glEnableVertexAttribArray(tilemap_program->Position_vec4);
+		//[z and w are filled with 0.0 and 1.0 automatically]
+
+		glBindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
+}
+
+TilemapLayer::~TilemapLayer() {
+	glDeleteVertexArrays(1, &quad_buffer_for_tilemap_program);
+	quad_buffer_for_tilemap_program = 0;
+	glDeleteBuffers(1, &quad_buffer);
+	quad_buffer = 0;
+	glDeleteTextures(1, &cells_tex);
+	cells_tex = 0;
+}
+
+void TilemapLayer::set_cells(uint32_t x, uint32_t y, uint32_t w, uint32_t h, glm::u8vec2 const *cells) {
+	assert(x + w <= width && y + h <= height);
+	glBindTexture(GL_TEXTURE_2D, cells_tex);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, GLint(x), GLint(y), GLsizei(w), GLsizei(h), GL_RG_INTEGER, GL_UNSIGNED_BYTE, cells);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	GL_ERRORS();
+}
+
+void TilemapLayer::draw(glm::mat4 const &level_to_clip, GLuint tileset_tex, glm::vec2 tileset_size) const {
+	glUseProgram(tilemap_program->program);
+
+	glUniformMatrix4fv(tilemap_program->OBJECT_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(level_to_clip));
+	glUniform1f(tilemap_program->TILE_SIZE_float, Level::TileSize);
+	glUniform2f(tilemap_program->CELL_SIZE_vec2, Level::TileSize / tileset_size.x, Level::TileSize / tileset_size.y);
+
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, cells_tex);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, tileset_tex);
+
+	glBindVertexArray(quad_buffer_for_tilemap_program);
+	glDrawArrays(GL_TRIANGLES, 0, 6);
+	glBindVertexArray(0);
+
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glUseProgram(0);
+
+	GL_ERRORS();
+}
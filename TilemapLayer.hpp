@@ -0,0 +1,40 @@
+#pragma once
+
+/*
+ * TilemapLayer draws a level's walls with a single quad: the tileset cell
+ * for each tile lives in an integer texture (one texel per tile) and
+ * TilemapProgram looks it up per fragment. Drawing costs the same on the
+ * CPU however big the level is; changing tiles is a glTexSubImage2D of
+ * just the changed texels (see set_cells()).
+ *
+ * Needs a current OpenGL context (and tilemap_program loaded) to construct.
+ */
+
+#include "LevelGeometry.hpp"
+
+#include "GL.hpp"
+#include <glm/glm.hpp>
+
+#include <vector>
+
+struct TilemapLayer {
+	//upload geometry.build_cells() as the layer's cells:
+	TilemapLayer(LevelGeometry const &geometry);
+	~TilemapLayer();
+	TilemapLayer(TilemapLayer const &) = delete;
+	TilemapLayer &operator=(TilemapLayer const &) = delete;
+
+	//replace the cells of tiles [x, x + w) x [y, y + h) with 'cells' (row-major, w * h entries):
+	void set_cells(uint32_t x, uint32_t y, uint32_t w, uint32_t h, glm::u8vec2 const *cells);
+
+	//draw every tile (level coordinates -> clip by level_to_clip), sampling the tileset texture:
+	// (uses the caller's blend state)
+	void draw(glm::mat4 const &level_to_clip, GLuint tileset_tex, glm::vec2 tileset_size) const;
+
+	uint32_t width = 0; //in tiles
+	uint32_t height = 0;
+
+	GLuint cells_tex = 0; //GL_RG8UI, width x height
+	GLuint quad_buffer = 0; //covers the level, in level coordinates
+	GLuint quad_buffer_for_tilemap_program = 0;
+};
@@ -0,0 +1,63 @@
+#include "TilemapProgram.hpp"
+
+#include "gl_compile_program.hpp"
+#include "gl_errors.hpp"
+
+Load< TilemapProgram > tilemap_program(LoadTagEarly);
+
+TilemapProgram::TilemapProgram() {
+	//Compile vertex and fragment shaders using the convenient 'gl_compile_program' helper function:
+	program = gl_compile_program(
+		//vertex shader:
+		"#version 330\n"
+		"uniform mat4 OBJECT_TO_CLIP;\n"
+		"in vec4 Position;\n"
+		"out vec2 levelPosition;\n"
+		"void main() {\n"
+		"	gl_Position = OBJECT_TO_CLIP * Position;\n"
+		"	levelPosition = Position.xy;\n"
+		"}\n"
+	,
+		//fragment shader:
+		"#version 330\n"
+		"uniform sampler2D TILESET;\n"
+		"uniform usampler2D CELLS;\n"
+		"uniform float TILE_SIZE;\n"
+		"uniform vec2 CELL_SIZE;\n"
+		"in vec2 levelPosition;\n"
+		"out vec4 fragColor;\n"
+		"void main() {\n"
+		"	vec2 at = levelPosition / TILE_SIZE;\n"
+		"	uvec2 cell = texelFetch(CELLS, ivec2(floor(at)), 0).rg;\n"
+		"	if (cell.x == 255u) discard;\n"
+		"	fragColor = texture(TILESET, (vec2(cell) + fract(at)) * CELL_SIZE);\n"
+		"}\n"
+	);
+	//As you can see above, adjacent strings in C/C++ are concatenated.
+	// this is very useful for writing long shader programs inline.
+
+	//look up the locations of vertex attributes:
+	Position_vec4 = glGetAttribLocation(program, "Position");
+
+	//look up the locations of uniforms:
+	OBJECT_TO_CLIP_mat4 = glGetUniformLocation(program, "OBJECT_TO_CLIP");
+	TILE_SIZE_float = glGetUniformLocation(program, "TILE_SIZE");
+	CELL_SIZE_vec2 = glGetUniformLocation(program, "CELL_SIZE");
+	GLuint TILESET_sampler2D = glGetUniformLocation(program, "TILESET");
+	GLuint CELLS_usampler2D = glGetUniformLocation(program, "CELLS");
+
+	//set TILESET and CELLS to always refer to texture bindings zero and one:
+	glUseProgram(program); //bind program -- glUniform* calls refer to this program now
+
+	glUniform1i(TILESET_sampler2D, 0); //set TILESET to sample from GL_TEXTURE0
+	glUniform1i(CELLS_usampler2D, 1); //set CELLS to sample from GL_TEXTURE1
+
+	glUseProgram(0); //unbind program -- glUniform* calls refer to ??? now
+
+	GL_ERRORS();
+}
+
+TilemapProgram::~TilemapProgram() {
+	glDeleteProgram(program);
+	program = 0;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "GL.hpp"
+#include "Load.hpp"
+
+//Shader program that draws a whole tile layer as one quad:
+// each fragment finds its tile in the CELLS texture and samples that cell of the tileset.
+struct TilemapProgram {
+	TilemapProgram();
+	~TilemapProgram();
+
+	GLuint program = 0;
+	//Attribute (per-vertex variable) locations:
+	GLuint Position_vec4 = -1U; //level coordinates (pixels)
+	//Uniform (per-invocation variable) locations:
+	GLuint OBJECT_TO_CLIP_mat4 = -1U;
+	GLuint TILE_SIZE_float = -1U; //size of a tile, in level coordinates
+	GLuint CELL_SIZE_vec2 = -1U; //size of a tileset cell, in texture coordinates
+	//Textures:
+	//TEXTURE0 - tileset
+	//TEXTURE1 - cells (GL_RG8UI): tileset (column, row) for each tile, or (255, 255) for none
+};
+
+extern Load< TilemapProgram > tilemap_program;
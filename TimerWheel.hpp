@@ -0,0 +1,97 @@
+#pragma once
+
+/*
+ * TimerWheel is a hashed timing wheel: a ring of 'slots' buckets, each
+ * covering 'resolution' seconds. Scheduling is O(1), cancelling searches only
+ * the item's own bucket, and advancing only touches the buckets whose time has
+ * come, so the cost of checking timeouts doesn't grow with the number of items
+ * being watched.
+ *
+ * Delays longer than the wheel's span are clamped to the last slot; callers
+ * are expected to re-check their item when it comes due and reschedule it if
+ * it isn't actually expired yet (which is also how activity "resets" a timer
+ * without having to move it between buckets).
+ *
+ * For example:
+
+TimerWheel< Connection * > wheel;
+connection->timeout_slot = wheel.schedule(connection, 5.0, now);
+//...later:
+wheel.advance(now, [&](Connection *c){
+	//c's slot has come due (it has already been removed from the wheel)
+});
+
+ */
+
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+
+template< typename T >
+struct TimerWheel {
+	typedef std::chrono::steady_clock Clock;
+
+	TimerWheel(double resolution_ = 0.25, uint32_t slot_count = 64) : slots(slot_count), resolution(resolution_) {
+		assert(resolution > 0.0);
+		assert(slot_count > 1);
+	}
+
+	//add 'item' to the slot that comes due 'delay' seconds after 'now'; returns the slot index (for cancel):
+	uint32_t schedule(T const &item, double delay, Clock::time_point now) {
+		if (!started) start(now);
+		uint64_t ticks = uint64_t(std::ceil(std::max(0.0, delay) / resolution));
+		ticks = std::max< uint64_t >(1, std::min< uint64_t >(ticks, slots.size() - 1));
+		uint32_t slot = uint32_t((current_tick + ticks) % slots.size());
+		slots[slot].emplace_back(item);
+		return slot;
+	}
+
+	//remove 'item' from slot 'slot' (as returned by schedule); does nothing if it isn't there:
+	// (linear in the size of that one bucket)
+	void cancel(T const &item, uint32_t slot) {
+		if (slot >= slots.size()) return;
+		auto &bucket = slots[slot];
+		auto f = std::find(bucket.begin(), bucket.end(), item);
+		if (f != bucket.end()) {
+			*f = bucket.back();
+			bucket.pop_back();
+		}
+	}
+
+	//call 'fn(item)' for every item in a slot that has come due by 'now':
+	// (the slot is emptied before the calls, so fn may safely reschedule its item)
+	template< typename F >
+	void advance(Clock::time_point now, F const &fn) {
+		if (!started) start(now);
+		uint64_t target = uint64_t(std::chrono::duration< double >(now - origin).count() / resolution);
+		//never spin around the wheel more than once:
+		if (target > current_tick + slots.size()) current_tick = target - slots.size();
+		while (current_tick < target) {
+			++current_tick;
+			uint32_t slot = uint32_t(current_tick % slots.size());
+			if (slots[slot].empty()) continue;
+			due.clear();
+			std::swap(due, slots[slot]);
+			for (auto const &item : due) {
+				fn(item);
+			}
+		}
+	}
+
+	std::vector< std::vector< T > > slots;
+	double resolution; //seconds per slot
+
+	//internals:
+	void start(Clock::time_point now) {
+		origin = now;
+		current_tick = 0;
+		started = true;
+	}
+	bool started = false;
+	Clock::time_point origin;
+	uint64_t current_tick = 0;
+	std::vector< T > due; //scratch storage for advance(), kept to avoid reallocating
+};
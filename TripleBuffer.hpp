@@ -0,0 +1,42 @@
+#pragma once
+
+/*
+ * TripleBuffer hands the latest value of something from one writer thread
+ * to one reader thread without either of them ever waiting:
+ *
+ *  - the writer fills back(), then publish()es it;
+ *  - the reader calls update(), which swaps in the most recent published
+ *    value (if there is one it hasn't seen) and then reads front().
+ *
+ * Three slots are enough that the writer always has one to itself, the
+ * reader always has one to itself, and the third holds the newest
+ * published value. Intermediate values may be skipped by the reader.
+ */
+
+#include <atomic>
+#include <cstdint>
+
+template< typename T >
+struct TripleBuffer {
+	//writer side:
+	T &back() { return slots[back_index]; }
+	void publish() {
+		back_index = middle.exchange(uint8_t(back_index | Fresh), std::memory_order_acq_rel) & IndexMask;
+	}
+
+	//reader side (returns true if front() changed):
+	bool update() {
+		if (!(middle.load(std::memory_order_relaxed) & Fresh)) return false;
+		front_index = middle.exchange(front_index, std::memory_order_acq_rel) & IndexMask;
+		return true;
+	}
+	T const &front() const { return slots[front_index]; }
+
+	//internals:
+	static constexpr uint8_t IndexMask = 0x3;
+	static constexpr uint8_t Fresh = 0x4; //set in 'middle' when it holds a value the reader hasn't taken
+	T slots[3];
+	uint8_t back_index = 0; //only touched by writer
+	uint8_t front_index = 1; //only touched by reader
+	std::atomic< uint8_t > middle{2};
+};
@@ -0,0 +1,220 @@
+//atlas_packer: packs a directory of PNG sprites into one texture
+// writes the packed image as a PNG, plus an atlas file ("str0" names +
+// "atl0" texture rectangles, see Atlas.hpp) for the client to look sprites up in.
+// Sprites are named by their file name without ".png"; each is surrounded by
+// 'padding' pixels copied from its edges, so filtering never picks up a neighbor.
+//
+//Usage (from atlas_packer/bin, like map_generator):
+//	./atlas_packer [sprite dir] [atlas png] [atlas file] [padding]
+
+#include "Atlas.hpp"
+#include "load_save_png.hpp"
+#include "read_write_chunk.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include <cstdlib>
+
+struct Sprite {
+	std::string name;
+	glm::uvec2 size = glm::uvec2(0);
+	std::vector< glm::u8vec4 > data; //rows top to bottom
+	glm::uvec2 at = glm::uvec2(0); //where the sprite (not its padding) lands in the atlas
+};
+
+//skyline bottom-left packer: keeps the top edge of everything placed so far as a list of
+// horizontal segments, and puts each rectangle where its top ends up lowest
+struct Skyline {
+	Skyline(uint32_t width_) : width(width_) {
+		segments.emplace_back(Segment{0, 0, width});
+	}
+	struct Segment {
+		uint32_t x, y, w;
+	};
+	uint32_t width;
+	std::vector< Segment > segments; //left to right, covering [0, width)
+	uint32_t height = 0; //tallest point so far
+
+	//place a w x h rectangle; returns false if it's wider than the skyline:
+	bool place(uint32_t w, uint32_t h, glm::uvec2 *at) {
+		size_t best = segments.size();
+		uint32_t best_y = 0, best_top = -1U, best_waste = -1U;
+		for (size_t i = 0; i < segments.size(); ++i) {
+			if (segments[i].x + w > width) break;
+			//rectangle rests on the highest segment it spans:
+			uint32_t y = 0;
+			uint32_t waste = 0;
+			for (size_t j = i; j < segments.size() && segments[j].x < segments[i].x + w; ++j) {
+				y = std::max(y, segments[j].y);
+			}
+			for (size_t j = i; j < segments.size() && segments[j].x < segments[i].x + w; ++j) {
+				uint32_t covered = std::min(segments[j].x + segments[j].w, segments[i].x + w) - segments[j].x;
+				waste += covered * (y - segments[j].y);
+			}
+			if (y + h < best_top || (y + h == best_top && waste < best_waste)) {
+				best = i;
+				best_y = y;
+				best_top = y + h;
+				best_waste = waste;
+			}
+		}
+		if (best == segments.size()) return false;
+
+		uint32_t x = segments[best].x;
+		*at = glm::uvec2(x, best_y);
+		height = std::max(height, best_y + h);
+
+		//replace the covered part of the skyline with the rectangle's top:
+		std::vector< Segment > next;
+		next.reserve(segments.size() + 2);
+		for (auto const &s : segments) {
+			uint32_t end = s.x + s.w;
+			if (end <= x || s.x >= x + w) {
+				next.emplace_back(s);
+				continue;
+			}
+			if (s.x < x) next.emplace_back(Segment{s.x, s.y, x - s.x});
+			if (s.x <= x) next.emplace_back(Segment{x, best_y + h, w});
+			if (end > x + w) next.emplace_back(Segment{x + w, s.y, end - (x + w)});
+		}
+		//merge neighbors at the same height:
+		segments.clear();
+		for (auto const &s : next) {
+			if (!segments.empty() && segments.back().y == s.y) segments.back().w += s.w;
+			else segments.emplace_back(s);
+		}
+		return true;
+	}
+};
+
+int main(int argc, char **argv) {
+#ifdef _WIN32
+	//when compiled on windows, unhandled exceptions don't have their message printed, which can make debugging simple issues difficult.
+	try {
+#endif
+
+	if (argc > 5) {
+		std::cerr << "Usage:\n\t./atlas_packer [sprite dir] [atlas png] [atlas file] [padding]" << std::endl;
+		return 1;
+	}
+	std::string sprite_dir = (argc >= 2 ? argv[1] : "../sprites");
+	std::string atlas_png = (argc >= 3 ? argv[2] : "../../dist/atlas.png");
+	std::string atlas_file = (argc >= 4 ? argv[3] : "../../dist/atlas");
+	uint32_t padding = (argc >= 5 ? uint32_t(std::atoi(argv[4])) : 1);
+
+	//load sprites:
+	std::vector< Sprite > sprites;
+	for (auto const &entry : std::filesystem::directory_iterator(sprite_dir)) {
+		if (!entry.is_regular_file() || entry.path().extension() != ".png") continue;
+		Sprite sprite;
+		sprite.name = entry.path().stem().string();
+		load_png(entry.path().string(), &sprite.size, &sprite.data, UpperLeftOrigin);
+		if (sprite.size.x == 0 || sprite.size.y == 0 || sprite.size.x > 0xffff || sprite.size.y > 0xffff) {
+			throw std::runtime_error("Sprite '" + entry.path().string() + "' has an unusable size.");
+		}
+		sprites.emplace_back(std::move(sprite));
+	}
+	if (sprites.empty()) {
+		throw std::runtime_error("No .png sprites in '" + sprite_dir + "'.");
+	}
+
+	//tallest first (ties by width, then name, so output doesn't depend on directory order):
+	std::sort(sprites.begin(), sprites.end(), [](Sprite const &a, Sprite const &b) {
+		if (a.size.y != b.size.y) return a.size.y > b.size.y;
+		if (a.size.x != b.size.x) return a.size.x > b.size.x;
+		return a.name < b.name;
+	});
+
+	//try power-of-two widths from about the square root of the total area up, keeping the smallest atlas:
+	uint64_t area = 0;
+	uint32_t widest = 0;
+	for (auto const &s : sprites) {
+		area += uint64_t(s.size.x + 2 * padding) * (s.size.y + 2 * padding);
+		widest = std::max(widest, s.size.x + 2 * padding);
+	}
+	uint32_t width = 1;
+	while (width < widest || uint64_t(width) * width < area) width *= 2;
+	if (width > 2) width /= 2;
+	if (width < widest) width *= 2;
+
+	glm::uvec2 best_size = glm::uvec2(0);
+	std::vector< glm::uvec2 > best_at;
+	for (uint32_t w = width; w <= 8192; w *= 2) {
+		Skyline skyline(w);
+		std::vector< glm::uvec2 > at(sprites.size());
+		bool fits = true;
+		for (size_t i = 0; i < sprites.size() && fits; ++i) {
+			fits = skyline.place(sprites[i].size.x + 2 * padding, sprites[i].size.y + 2 * padding, &at[i]);
+		}
+		if (!fits) continue;
+		glm::uvec2 size = glm::uvec2(w, skyline.height);
+		if (best_at.empty() || uint64_t(size.x) * size.y < uint64_t(best_size.x) * best_size.y) {
+			best_size = size;
+			best_at = at;
+		}
+		if (skyline.height <= w) break; //wider only gets flatter from here
+	}
+	if (best_at.empty()) {
+		throw std::runtime_error("Sprites don't fit in an 8192-pixel-wide atlas.");
+	}
+
+	//copy sprites (and their edges, into the padding) into the atlas:
+	std::vector< glm::u8vec4 > image(best_size.x * best_size.y, glm::u8vec4(0, 0, 0, 0));
+	for (size_t i = 0; i < sprites.size(); ++i) {
+		Sprite &s = sprites[i];
+		s.at = best_at[i] + glm::uvec2(padding);
+		for (uint32_t y = 0; y < s.size.y + 2 * padding; ++y) {
+			uint32_t sy = uint32_t(std::min< int64_t >(std::max< int64_t >(int64_t(y) - padding, 0), s.size.y - 1));
+			for (uint32_t x = 0; x < s.size.x + 2 * padding; ++x) {
+				uint32_t sx = uint32_t(std::min< int64_t >(std::max< int64_t >(int64_t(x) - padding, 0), s.size.x - 1));
+				image[(best_at[i].y + y) * best_size.x + (best_at[i].x + x)] = s.data[sy * s.size.x + sx];
+			}
+		}
+	}
+	save_png(atlas_png, best_size, image.data(), UpperLeftOrigin);
+
+	//names + texture rectangles, in name order:
+	std::sort(sprites.begin(), sprites.end(), [](Sprite const &a, Sprite const &b) {
+		return a.name < b.name;
+	});
+	std::vector< char > strings;
+	std::vector< Atlas::Entry > entries;
+	for (auto const &s : sprites) {
+		Atlas::Entry entry;
+		entry.name_begin = uint32_t(strings.size());
+		strings.insert(strings.end(), s.name.begin(), s.name.end());
+		entry.name_end = uint32_t(strings.size());
+		entry.tex = glm::vec2(s.at) / glm::vec2(best_size);
+		entry.tex_size = glm::vec2(s.size) / glm::vec2(best_size);
+		entry.width = uint16_t(s.size.x);
+		entry.height = uint16_t(s.size.y);
+		entries.emplace_back(entry);
+	}
+
+	std::ofstream out(atlas_file, std::ios::binary);
+	write_chunk< char >("str0", strings, &out);
+	write_chunk< Atlas::Entry >("atl0", entries, &out);
+	if (!out) {
+		throw std::runtime_error("Failed to write '" + atlas_file + "'.");
+	}
+
+	std::cout << "Packed " << sprites.size() << " sprites into " << best_size.x << "x" << best_size.y
+	          << " (" << int(100.0 * double(area) / (double(best_size.x) * best_size.y)) << "% used)." << std::endl;
+
+	return 0;
+
+#ifdef _WIN32
+	} catch (std::exception const &e) {
+		std::cerr << "Unhandled exception:\n" << e.what() << std::endl;
+		return 1;
+	} catch (...) {
+		std::cerr << "Unhandled exception (unknown type)." << std::endl;
+		throw;
+	}
+#endif
+}
@@ -0,0 +1,158 @@
+//bench-aabb: microbenchmarks for AABBSet.cpp
+// measures one-box-against-N overlap tests with the scalar and SIMD kernels
+// (checking that they agree), at player-count sizes and at the level's solid
+// tiles, where the tile-grid lookup Level::overlap is timed for comparison.
+// Results are printed to stdout as JSON, like bench-net.
+//
+//Usage:
+//	./bench-aabb [level file] [seconds per case]
+
+#include "AABBSet.hpp"
+#include "Level.hpp"
+#include "data_path.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <random>
+#include <cmath>
+#include <stdexcept>
+#include <cstdlib>
+
+typedef std::chrono::steady_clock Clock;
+
+static double seconds_since(Clock::time_point const &t) {
+	return std::chrono::duration< double >(Clock::now() - t).count();
+}
+
+struct Query {
+	float x, y, w, h;
+};
+
+//random player-sized query boxes spread over 'extent':
+static std::vector< Query > make_queries(float extent, std::mt19937 &mt) {
+	std::uniform_real_distribution< float > coord(0.0f, extent);
+	std::vector< Query > queries(1024);
+	for (auto &q : queries) {
+		q = Query{coord(mt), coord(mt), Level::TileSize, Level::TileSize};
+	}
+	return queries;
+}
+
+//run 'fn(query)' over the queries until 'duration' has passed; returns nanoseconds per query:
+template< typename F >
+static double time_queries(std::vector< Query > const &queries, double duration, F const &fn) {
+	uint64_t calls = 0;
+	auto start = Clock::now();
+	double elapsed = 0.0;
+	do {
+		for (auto const &q : queries) fn(q);
+		calls += queries.size();
+		elapsed = seconds_since(start);
+	} while (elapsed < duration);
+	return elapsed * 1e9 / double(calls);
+}
+
+static std::string bench_set(std::string const &name, AABBSet const &set, std::vector< Query > const &queries, double duration) {
+	std::vector< uint32_t > mask(set.mask_words()), expected(set.mask_words());
+	uint64_t hits = 0; //summed so the compiler can't skip the work
+
+	//check the kernels agree before timing them:
+	for (auto const &q : queries) {
+		set.overlaps_scalar(q.x, q.y, q.w, q.h, expected.data());
+		set.overlaps(q.x, q.y, q.w, q.h, mask.data());
+		if (mask != expected) throw std::runtime_error("AABBSet kernels disagree on '" + name + "'.");
+	}
+
+	double scalar_ns = time_queries(queries, duration, [&](Query const &q) {
+		set.overlaps_scalar(q.x, q.y, q.w, q.h, mask.data());
+		hits += mask[0];
+	});
+	double simd_ns = time_queries(queries, duration, [&](Query const &q) {
+		set.overlaps(q.x, q.y, q.w, q.h, mask.data());
+		hits += mask[0];
+	});
+
+	std::ostringstream out;
+	out << "{ \"name\": \"" << name << "\""
+	    << ", \"boxes\": " << set.size()
+	    << ", \"scalar_ns\": " << scalar_ns
+	    << ", \"" << AABBSet::kernel() << "_ns\": " << simd_ns
+	    << ", \"speedup\": " << scalar_ns / simd_ns
+	    << ", \"checksum\": " << (hits & 0xff)
+	    << " }";
+	return out.str();
+}
+
+int main(int argc, char **argv) {
+#ifdef _WIN32
+	//when compiled on windows, unhandled exceptions don't have their message printed, which can make debugging simple issues difficult.
+	try {
+#endif
+
+	if (argc > 3) {
+		std::cerr << "Usage:\n\t./bench-aabb [level file] [seconds per case]" << std::endl;
+		return 1;
+	}
+	std::string level_file = (argc >= 2 ? argv[1] : data_path("../dist/level_data"));
+	double duration = (argc >= 3 ? std::atof(argv[2]) : 0.5);
+
+	std::mt19937 mt(0x0aabb);
+	std::vector< std::string > cases;
+
+	//players: random boxes in a small arena so that some of them overlap:
+	for (uint32_t count : {8, 64, 1024}) {
+		float extent = 20.0f * std::sqrt(float(count)) * 2.0f;
+		std::uniform_real_distribution< float > coord(0.0f, extent);
+		AABBSet set;
+		for (uint32_t i = 0; i < count; ++i) {
+			set.add(coord(mt), coord(mt), 20.0f, 20.0f);
+		}
+		cases.emplace_back(bench_set("players-" + std::to_string(count), set, make_queries(extent, mt), duration));
+	}
+
+	//walls: a box per solid tile, against the tile grid:
+	Level level(level_file);
+	AABBSet walls;
+	for (uint32_t y = 0; y < level.height; ++y) {
+		for (uint32_t x = 0; x < level.width; ++x) {
+			if (!(level.flag(x, y) & Level::Solid)) continue;
+			walls.add(x * Level::TileSize, y * Level::TileSize, Level::TileSize, Level::TileSize);
+		}
+	}
+	std::vector< Query > queries = make_queries(level.width * Level::TileSize, mt);
+	cases.emplace_back(bench_set("level-tiles", walls, queries, duration));
+
+	uint64_t solid = 0;
+	double grid_ns = time_queries(queries, duration, [&](Query const &q) {
+		solid += level.overlap(q.x, q.y, q.w, q.h) & Level::Solid;
+	});
+
+	std::string joined;
+	for (auto const &c : cases) {
+		if (!joined.empty()) joined += ",\n\t\t";
+		joined += c;
+	}
+
+	std::cout << "{\n"
+	          << "\t\"kernel\": \"" << AABBSet::kernel() << "\",\n"
+	          << "\t\"seconds_per_case\": " << duration << ",\n"
+	          << "\t\"cases\": [\n\t\t" << joined << "\n\t],\n"
+	          << "\t\"level_grid_overlap_ns\": " << grid_ns << ",\n"
+	          << "\t\"level_grid_checksum\": " << (solid & 0xff) << "\n"
+	          << "}" << std::endl;
+
+	return 0;
+
+#ifdef _WIN32
+	} catch (std::exception const &e) {
+		std::cerr << "Unhandled exception:\n" << e.what() << std::endl;
+		return 1;
+	} catch (...) {
+		std::cerr << "Unhandled exception (unknown type)." << std::endl;
+		throw;
+	}
+#endif
+}
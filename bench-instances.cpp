@@ -0,0 +1,127 @@
+//bench-instances: microbenchmark for packing sprites on the CPU
+// compares building a frame's worth of sprites as SpriteVertex quads
+// (six vertices each, via append_quad and append_quads) against packing them
+// as SpriteInstance records for instanced drawing, and reports the bytes each
+// way would upload.
+// Results are printed to stdout as JSON, like bench-net.
+//
+//Usage:
+//	./bench-instances [sprites] [frames]
+
+#include "SpriteInstance.hpp"
+#include "LevelGeometry.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <random>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+typedef std::chrono::steady_clock Clock;
+
+static double seconds_since(Clock::time_point const &t) {
+	return std::chrono::duration< double >(Clock::now() - t).count();
+}
+
+int main(int argc, char **argv) {
+#ifdef _WIN32
+	//when compiled on windows, unhandled exceptions don't have their message printed, which can make debugging simple issues difficult.
+	try {
+#endif
+
+	if (argc > 3) {
+		std::cerr << "Usage:\n\t./bench-instances [sprites] [frames]" << std::endl;
+		return 1;
+	}
+	uint32_t count = (argc >= 2 ? uint32_t(std::atoi(argv[1])) : 4096);
+	uint32_t frames = (argc >= 3 ? uint32_t(std::atoi(argv[2])) : 2000);
+
+	//sprites scattered over a 640x640 window, sized like players / glyphs, from a table of 64 frames:
+	SpriteFrames table;
+	for (uint32_t i = 0; i < SpriteFrames::MaxFrames; ++i) {
+		table.add(glm::vec2(float(i % 8) / 8.0f, float(i / 8) / 8.0f), glm::vec2(1.0f / 8.0f));
+	}
+	std::mt19937 mt(0x5b1735);
+	std::uniform_real_distribution< float > coord(-320.0f, 320.0f);
+	std::uniform_int_distribution< uint32_t > pick(0, SpriteFrames::MaxFrames - 1);
+	std::vector< SpriteQuad > quads(count);
+	std::vector< uint16_t > frame_of(count);
+	for (uint32_t i = 0; i < count; ++i) {
+		frame_of[i] = uint16_t(pick(mt));
+		glm::vec4 const &rect = table.rects[frame_of[i]];
+		quads[i].pos = glm::vec2(coord(mt), coord(mt));
+		quads[i].size = (i % 2 ? glm::vec2(20.0f, 20.0f) : glm::vec2(22.0f, 26.0f));
+		quads[i].tex = glm::vec2(rect.x, rect.y);
+		quads[i].tex_size = glm::vec2(rect.z, rect.w);
+		quads[i].color = glm::u8vec4(uint8_t(i), uint8_t(i >> 8), 255, 255);
+	}
+
+	//time 'frames' repetitions of 'pack' into storage that's kept between frames (like the batches do):
+	auto sprites_per_second = [&](auto &storage, auto &&pack) {
+		pack(storage); //warm up (and grow storage)
+		auto start = Clock::now();
+		for (uint32_t f = 0; f < frames; ++f) {
+			storage.clear();
+			pack(storage);
+		}
+		return double(count) * frames / seconds_since(start);
+	};
+
+	std::vector< SpriteVertex > vertices;
+	double quad_sps = sprites_per_second(vertices, [&](std::vector< SpriteVertex > &out) {
+		for (uint32_t i = 0; i < count; ++i) {
+			append_quad(out, quads[i]);
+		}
+	});
+	double quads_sps = sprites_per_second(vertices, [&](std::vector< SpriteVertex > &out) {
+		append_quads(out, quads.data(), quads.size());
+	});
+	size_t vertex_bytes = vertices.size() * sizeof(SpriteVertex);
+
+	std::vector< SpriteInstance > instances;
+	double instance_sps = sprites_per_second(instances, [&](std::vector< SpriteInstance > &out) {
+		for (uint32_t i = 0; i < count; ++i) {
+			out.emplace_back(quads[i].pos, quads[i].size, frame_of[i], quads[i].color);
+		}
+	});
+	size_t instance_bytes = instances.size() * sizeof(SpriteInstance) + table.rects.size() * sizeof(table.rects[0]);
+
+	//positions round to the nearest 1 / PositionScale pixel; sizes are whole pixels here, so exact:
+	float max_error = 0.0f;
+	bool exact = true;
+	for (uint32_t i = 0; i < count; ++i) {
+		SpriteInstance const &inst = instances[i];
+		max_error = std::max(max_error, std::abs(inst.pos.x / SpriteInstance::PositionScale - quads[i].pos.x));
+		max_error = std::max(max_error, std::abs(inst.pos.y / SpriteInstance::PositionScale - quads[i].pos.y));
+		if (float(inst.size.x) != quads[i].size.x || float(inst.size.y) != quads[i].size.y) exact = false;
+		if (inst.frame != frame_of[i] || inst.color != quads[i].color) exact = false;
+	}
+	bool ok = exact && max_error <= 0.5f / SpriteInstance::PositionScale;
+
+	std::cout << "{\n"
+	          << "\t\"sprites\": " << count << ",\n"
+	          << "\t\"frames\": " << frames << ",\n"
+	          << "\t\"append_quads_kernel\": \"" << append_quads_kernel() << "\",\n"
+	          << "\t\"vertices\": { \"bytes_per_sprite\": " << 6 * sizeof(SpriteVertex) << ", \"bytes_per_frame\": " << vertex_bytes
+	          << ", \"append_quad_sprites_per_second\": " << quad_sps << ", \"append_quads_sprites_per_second\": " << quads_sps << " },\n"
+	          << "\t\"instances\": { \"bytes_per_sprite\": " << sizeof(SpriteInstance) << ", \"bytes_per_frame\": " << instance_bytes
+	          << ", \"sprites_per_second\": " << instance_sps << " },\n"
+	          << "\t\"max_position_error_px\": " << max_error << ",\n"
+	          << "\t\"ok\": " << (ok ? "true" : "false") << "\n"
+	          << "}" << std::endl;
+
+	return ok ? 0 : 1;
+
+#ifdef _WIN32
+	} catch (std::exception const &e) {
+		std::cerr << "Unhandled exception:\n" << e.what() << std::endl;
+		return 1;
+	} catch (...) {
+		std::cerr << "Unhandled exception (unknown type)." << std::endl;
+		throw;
+	}
+#endif
+}
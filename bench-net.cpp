@@ -0,0 +1,282 @@
+//bench-net: loopback microbenchmarks for Connection.cpp
+// measures small-message echo throughput + latency at several connection counts,
+// the connect/accept rate, and the cost of broadcasting a snapshot-sized message.
+// Results are printed to stdout as JSON, so runs on different transports can be diffed.
+//
+//Usage:
+//	./bench-net [port] [seconds per case]
+
+#include "Connection.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <memory>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+#include <cstdlib>
+
+typedef std::chrono::steady_clock Clock;
+
+static double seconds_since(Clock::time_point const &t) {
+	return std::chrono::duration< double >(Clock::now() - t).count();
+}
+
+//Server and Client constructors chat on std::cout; keep that out of the JSON:
+struct MuteCout {
+	MuteCout() : old(std::cout.rdbuf(sink.rdbuf())) { }
+	~MuteCout() { std::cout.rdbuf(old); }
+	std::ostringstream sink;
+	std::streambuf *old;
+};
+
+struct Rig {
+	Rig(std::string const &port_) : port(port_) {
+		MuteCout mute;
+		server.reset(new Server(port));
+	}
+	std::string port;
+	std::unique_ptr< Server > server;
+	std::vector< std::unique_ptr< Client > > clients;
+
+	//open 'count' client connections, accepting each on the server as it arrives:
+	// (accepting as we go keeps the listen backlog from filling up)
+	void connect(uint32_t count) {
+		MuteCout mute;
+		size_t target = server->connections.size() + count;
+		for (uint32_t i = 0; i < count; ++i) {
+			clients.emplace_back(new Client("127.0.0.1", port));
+			server->poll(nullptr, 0.0);
+		}
+		while (server->connections.size() < target) {
+			server->poll(nullptr, 0.001);
+		}
+	}
+
+	//close all client connections and wait for the server to notice:
+	void disconnect() {
+		for (auto &client : clients) {
+			client->connection.close();
+		}
+		clients.clear();
+		auto start = Clock::now();
+		while (!server->connections.empty() && seconds_since(start) < 5.0) {
+			server->poll(nullptr, 0.001);
+		}
+	}
+};
+
+//percentile of (sorted) samples:
+static double percentile(std::vector< double > const &sorted, double p) {
+	if (sorted.empty()) return 0.0;
+	size_t i = std::min(sorted.size() - 1, size_t(p * double(sorted.size())));
+	return sorted[i];
+}
+
+static std::string skipped(uint32_t connections) {
+	std::ostringstream out;
+	out << "{ \"connections\": " << connections << ", \"skipped\": \"needs " << (2 * connections + 1)
+	    << " sockets; backend '" << ConnectionBackend << "' handles " << ConnectionMaxSockets << "\" }";
+	return out.str();
+}
+
+//every client keeps one small message in flight; the server echoes them back:
+static std::string bench_echo(Rig &rig, uint32_t connections, double duration) {
+	if (2 * connections + 1 > ConnectionMaxSockets) return skipped(connections);
+
+	rig.connect(connections);
+
+	struct Message {
+		char type = 'e';
+		char padding[7] = {0, 0, 0, 0, 0, 0, 0};
+		int64_t sent = 0; //nanoseconds, Clock time base
+	};
+	static_assert(sizeof(Message) == 16, "Message is packed");
+
+	auto now_ns = []() {
+		return int64_t(std::chrono::duration_cast< std::chrono::nanoseconds >(Clock::now().time_since_epoch()).count());
+	};
+	auto send_message = [&](Connection &c) {
+		Message m;
+		m.sent = now_ns();
+		c.send(m);
+	};
+
+	std::vector< double > latencies; //microseconds
+	latencies.reserve(1 << 20);
+
+	for (auto &client : rig.clients) {
+		send_message(client->connection);
+	}
+
+	auto start = Clock::now();
+	while (seconds_since(start) < duration) {
+		rig.server->poll([](Connection *c, Connection::Event evt){
+			if (evt != Connection::OnRecv) return;
+			c->send_buffer.insert(c->send_buffer.end(), c->recv_buffer.begin(), c->recv_buffer.end());
+			c->recv_buffer.clear();
+		}, 0.0);
+		for (auto &client : rig.clients) {
+			client->poll([&](Connection *c, Connection::Event evt){
+				if (evt != Connection::OnRecv) return;
+				while (c->recv_buffer.size() >= sizeof(Message)) {
+					Message m;
+					std::memcpy(&m, c->recv_buffer.data(), sizeof(Message));
+					c->recv_buffer.erase(c->recv_buffer.begin(), c->recv_buffer.begin() + sizeof(Message));
+					latencies.emplace_back(double(now_ns() - m.sent) * 1e-3);
+					send_message(*c);
+				}
+			}, 0.0);
+		}
+	}
+	double elapsed = seconds_since(start);
+
+	rig.disconnect();
+
+	std::sort(latencies.begin(), latencies.end());
+	std::ostringstream out;
+	out << "{ \"connections\": " << connections
+	    << ", \"messages\": " << latencies.size()
+	    << ", \"messages_per_second\": " << double(latencies.size()) / elapsed
+	    << ", \"latency_us\": { \"p50\": " << percentile(latencies, 0.50)
+	    << ", \"p90\": " << percentile(latencies, 0.90)
+	    << ", \"p99\": " << percentile(latencies, 0.99)
+	    << ", \"max\": " << (latencies.empty() ? 0.0 : latencies.back())
+	    << " } }";
+	return out.str();
+}
+
+//open (and accept) connections as fast as possible:
+static std::string bench_connect(Rig &rig, uint32_t connections) {
+	if (2 * connections + 1 > ConnectionMaxSockets) return skipped(connections);
+
+	auto start = Clock::now();
+	rig.connect(connections);
+	double elapsed = seconds_since(start);
+
+	rig.disconnect();
+
+	std::ostringstream out;
+	out << "{ \"connections\": " << connections
+	    << ", \"seconds\": " << elapsed
+	    << ", \"connects_per_second\": " << double(connections) / elapsed
+	    << " }";
+	return out.str();
+}
+
+//server sends one snapshot-sized message to every client; measures the server's cost to
+// queue + flush it and the time until every client has it:
+static std::string bench_broadcast(Rig &rig, uint32_t connections, double duration) {
+	if (2 * connections + 1 > ConnectionMaxSockets) return skipped(connections);
+
+	rig.connect(connections);
+
+	//same size as an 8-player 'a' message:
+	std::vector< char > message(3 + 5 * 8, 'b');
+
+	std::vector< double > send_costs; //microseconds for the server to queue + flush a broadcast
+	std::vector< double > delivery_times; //microseconds until all clients have it
+
+	auto start = Clock::now();
+	while (seconds_since(start) < duration) {
+		auto round_start = Clock::now();
+		for (auto &c : rig.server->connections) {
+			c.send_buffer.insert(c.send_buffer.end(), message.begin(), message.end());
+		}
+		bool flushed = false;
+		while (!flushed) {
+			rig.server->poll(nullptr, 0.0);
+			flushed = true;
+			for (auto const &c : rig.server->connections) {
+				if (!c.send_buffer.empty()) flushed = false;
+			}
+		}
+		send_costs.emplace_back(seconds_since(round_start) * 1e6);
+
+		size_t waiting = rig.clients.size();
+		while (waiting > 0) {
+			for (auto &client : rig.clients) {
+				if (client->connection.recv_buffer.size() >= message.size()) continue;
+				client->poll(nullptr, 0.0);
+				if (client->connection.recv_buffer.size() >= message.size()) waiting -= 1;
+			}
+		}
+		delivery_times.emplace_back(seconds_since(round_start) * 1e6);
+		for (auto &client : rig.clients) {
+			client->connection.recv_buffer.clear();
+		}
+	}
+
+	rig.disconnect();
+
+	std::sort(send_costs.begin(), send_costs.end());
+	std::sort(delivery_times.begin(), delivery_times.end());
+	double p50 = percentile(send_costs, 0.50);
+	std::ostringstream out;
+	out << "{ \"connections\": " << connections
+	    << ", \"message_bytes\": " << message.size()
+	    << ", \"broadcasts\": " << send_costs.size()
+	    << ", \"server_cost_us\": { \"p50\": " << p50 << ", \"p99\": " << percentile(send_costs, 0.99) << " }"
+	    << ", \"server_cost_per_connection_us\": " << p50 / double(connections)
+	    << ", \"delivery_us\": { \"p50\": " << percentile(delivery_times, 0.50) << ", \"p99\": " << percentile(delivery_times, 0.99) << " }"
+	    << " }";
+	return out.str();
+}
+
+int main(int argc, char **argv) {
+#ifdef _WIN32
+	//when compiled on windows, unhandled exceptions don't have their message printed, which can make debugging simple issues difficult.
+	try {
+#endif
+
+	if (argc > 3) {
+		std::cerr << "Usage:\n\t./bench-net [port] [seconds per case]" << std::endl;
+		return 1;
+	}
+	std::string port = (argc >= 2 ? argv[1] : "15499");
+	double duration = (argc >= 3 ? std::atof(argv[2]) : 2.0);
+
+	Rig rig(port);
+
+	std::vector< std::string > echo;
+	for (uint32_t connections : {1, 8, 64, 1024}) {
+		echo.emplace_back(bench_echo(rig, connections, duration));
+	}
+	std::string connect = bench_connect(rig, 256);
+	std::vector< std::string > broadcast;
+	for (uint32_t connections : {8, 64}) {
+		broadcast.emplace_back(bench_broadcast(rig, connections, duration));
+	}
+
+	auto join = [](std::vector< std::string > const &items) {
+		std::string ret;
+		for (auto const &item : items) {
+			if (!ret.empty()) ret += ",\n\t\t";
+			ret += item;
+		}
+		return ret;
+	};
+
+	std::cout << "{\n"
+	          << "\t\"backend\": \"" << ConnectionBackend << "\",\n"
+	          << "\t\"seconds_per_case\": " << duration << ",\n"
+	          << "\t\"echo\": [\n\t\t" << join(echo) << "\n\t],\n"
+	          << "\t\"connect\": " << connect << ",\n"
+	          << "\t\"broadcast\": [\n\t\t" << join(broadcast) << "\n\t]\n"
+	          << "}" << std::endl;
+
+	return 0;
+
+#ifdef _WIN32
+	} catch (std::exception const &e) {
+		std::cerr << "Unhandled exception:\n" << e.what() << std::endl;
+		return 1;
+	} catch (...) {
+		std::cerr << "Unhandled exception (unknown type)." << std::endl;
+		throw;
+	}
+#endif
+}
@@ -0,0 +1,172 @@
+//bench-rollback: microbenchmark for Rollback.cpp
+// eight players whose inputs change every frame; the remote players' inputs
+// arrive 'delay' frames late, so nearly every frame rolls back 'delay' frames
+// and re-simulates all eight players. Also times saving/restoring a SimState,
+// and checks that the rolled-back run ends up exactly where a run that knew
+// every input in advance does.
+// Results are printed to stdout as JSON, like bench-net.
+//
+//Usage:
+//	./bench-rollback [level file] [frames] [delay]
+
+#include "Rollback.hpp"
+#include "map_generator.hpp"
+#include "data_path.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+#include <cstdlib>
+#include <type_traits>
+
+typedef std::chrono::steady_clock Clock;
+
+static double seconds_since(Clock::time_point const &t) {
+	return std::chrono::duration< double >(Clock::now() - t).count();
+}
+
+//percentile of (sorted) samples:
+static double percentile(std::vector< double > const &sorted, double p) {
+	if (sorted.empty()) return 0.0;
+	size_t i = std::min(sorted.size() - 1, size_t(p * double(sorted.size())));
+	return sorted[i];
+}
+
+//scripted input for player 'index' in frame 'frame' (changes most frames):
+static Rollback::Input input_for(uint32_t index, uint32_t frame) {
+	uint32_t h = (frame * 2654435761u) ^ (index * 40503u);
+	h ^= h >> 15;
+	h *= 2246822519u;
+	h ^= h >> 13;
+	//hold left/right for a while so players actually travel, but flip jump often:
+	Rollback::Input input = Rollback::unpack(uint8_t(((frame / 20 + index) % 3 == 0 ? 1 : 2) | (h & 4)));
+	if (h & 0x100) input.left = !input.left;
+	return input;
+}
+
+static bool same_state(SimState const &a, SimState const &b) {
+	if (a.frame != b.frame || a.exists != b.exists || a.it != b.it) return false;
+	if (std::memcmp(a.touching, b.touching, sizeof(a.touching)) != 0) return false;
+	for (uint32_t i = 0; i < SimState::MaxPlayers; ++i) {
+		SimState::Body const &p = a.bodies[i], &q = b.bodies[i];
+		if (!(p.x == q.x && p.y == q.y && p.vx == q.vx && p.vy == q.vy)) return false;
+		if (p.airborne != q.airborne || p.sliding_left != q.sliding_left || p.sliding_right != q.sliding_right || p.can_jump != q.can_jump) return false;
+	}
+	return true;
+}
+
+int main(int argc, char **argv) {
+#ifdef _WIN32
+	//when compiled on windows, unhandled exceptions don't have their message printed, which can make debugging simple issues difficult.
+	try {
+#endif
+
+	if (argc > 4) {
+		std::cerr << "Usage:\n\t./bench-rollback [level file] [frames] [delay]" << std::endl;
+		return 1;
+	}
+	std::string level_file = (argc >= 2 ? argv[1] : data_path("../dist/level_data"));
+	uint32_t frames = (argc >= 3 ? uint32_t(std::atoi(argv[2])) : 20000);
+	uint32_t delay = (argc >= 4 ? uint32_t(std::atoi(argv[3])) : 8);
+	if (delay == 0 || delay >= Rollback::Window) {
+		std::cerr << "delay must be between 1 and " << (Rollback::Window - 1) << " frames." << std::endl;
+		return 1;
+	}
+
+	Level level(level_file);
+	std::vector< SimState::Body > spawns;
+	for (uint32_t y = 0; y < level.height; ++y) {
+		for (uint32_t x = 0; x < level.width; ++x) {
+			if (level.tile(x, y) != TILE_SPAWN) continue;
+			SimState::Body body;
+			body.x = int32_t(x) * GamePhysics::TileSize;
+			body.y = int32_t(y) * GamePhysics::TileSize;
+			spawns.emplace_back(body);
+		}
+	}
+	if (spawns.empty()) throw std::runtime_error("Level has no spawn points.");
+
+	constexpr uint32_t Rate = 120;
+	Rollback reference(level, Rate, spawns); //gets every input before it is needed
+	Rollback rollback(level, Rate, spawns); //gets remote inputs 'delay' frames late
+	for (uint8_t i = 0; i < SimState::MaxPlayers; ++i) {
+		reference.join(i);
+		rollback.join(i);
+	}
+
+	std::vector< double > advance_us; //every advance()
+	std::vector< double > rollback_us; //advance() calls that rolled back
+	for (uint32_t f = 0; f < frames; ++f) {
+		for (uint8_t i = 0; i < SimState::MaxPlayers; ++i) {
+			reference.add_input(i, f, input_for(i, f));
+		}
+		reference.advance();
+
+		//local player's input is known right away; everyone else's shows up late:
+		rollback.add_input(0, f, input_for(0, f));
+		if (f >= delay) {
+			for (uint8_t i = 1; i < SimState::MaxPlayers; ++i) {
+				rollback.add_input(i, f - delay, input_for(i, f - delay));
+			}
+		}
+		uint32_t before = rollback.rollbacks;
+		auto start = Clock::now();
+		rollback.advance();
+		double us = seconds_since(start) * 1e6;
+		advance_us.emplace_back(us);
+		if (rollback.rollbacks != before) rollback_us.emplace_back(us);
+	}
+
+	//deliver the inputs still in flight, then both take one more (fully known) frame:
+	for (uint32_t f = (frames >= delay ? frames - delay : 0); f <= frames; ++f) {
+		for (uint8_t i = 0; i < SimState::MaxPlayers; ++i) {
+			rollback.add_input(i, f, input_for(i, f));
+			reference.add_input(i, f, input_for(i, f));
+		}
+	}
+	reference.advance();
+	rollback.advance();
+	bool matches = same_state(reference.state, rollback.state);
+
+	//cost of saving + restoring the whole simulation:
+	SimState copy;
+	uint32_t copies = 1000000;
+	auto start = Clock::now();
+	for (uint32_t i = 0; i < copies; ++i) {
+		std::memcpy(&copy, &rollback.history[i % Rollback::Slots], sizeof(SimState));
+		std::memcpy(&rollback.history[(i + 1) % Rollback::Slots], &copy, sizeof(SimState));
+	}
+	double copy_ns = seconds_since(start) * 1e9 / double(copies);
+
+	std::sort(advance_us.begin(), advance_us.end());
+	std::sort(rollback_us.begin(), rollback_us.end());
+	std::cout << "{\n"
+	          << "\t\"physics\": \"" << (std::is_same< decltype(SimState::Body::x), Fixed >::value ? "fixed" : "float") << "\",\n"
+	          << "\t\"players\": " << SimState::MaxPlayers << ",\n"
+	          << "\t\"frames\": " << frames << ",\n"
+	          << "\t\"delay_frames\": " << delay << ",\n"
+	          << "\t\"sim_state_bytes\": " << sizeof(SimState) << ",\n"
+	          << "\t\"save_restore_ns\": " << copy_ns << ",\n"
+	          << "\t\"rollbacks\": " << rollback.rollbacks << ",\n"
+	          << "\t\"resimulated_frames\": " << rollback.resimulated_frames << ",\n"
+	          << "\t\"advance_us\": { \"p50\": " << percentile(advance_us, 0.50) << ", \"p99\": " << percentile(advance_us, 0.99) << ", \"max\": " << (advance_us.empty() ? 0.0 : advance_us.back()) << " },\n"
+	          << "\t\"rollback_us\": { \"p50\": " << percentile(rollback_us, 0.50) << ", \"p99\": " << percentile(rollback_us, 0.99) << ", \"max\": " << (rollback_us.empty() ? 0.0 : rollback_us.back()) << " },\n"
+	          << "\t\"matches_reference\": " << (matches ? "true" : "false") << "\n"
+	          << "}" << std::endl;
+
+	return matches ? 0 : 1;
+
+#ifdef _WIN32
+	} catch (std::exception const &e) {
+		std::cerr << "Unhandled exception:\n" << e.what() << std::endl;
+		return 1;
+	} catch (...) {
+		std::cerr << "Unhandled exception (unknown type)." << std::endl;
+		throw;
+	}
+#endif
+}
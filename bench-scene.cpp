@@ -0,0 +1,139 @@
+//bench-scene: counts the GL calls Scene::draw makes for a scene file
+// Scene::draw sorts drawables with a RenderQueue and only changes state between
+// drawables that need different state; this compares the calls that makes against
+// the calls the old unsorted loop (set everything per drawable, unbind textures
+// after each) would make for the same scene. It also compares the per-draw
+// glBindBufferRange calls for the Object / Material uniform blocks against the
+// glUniform* calls the old loop made for the matrices. No GL context is needed:
+// pipelines get made-up GL names, set up two ways:
+//  "show_scene" -- one program + vertex array, no textures, Object block (what show-scene does)
+//  "textured" -- two programs (alternating by mesh name), one vertex array, a
+//    texture per mesh name (as when each mesh has its own material texture), and
+//    one of four materials (by mesh name), as with lit_color_texture_program
+// Also times building + sorting the queue.
+// Results are printed to stdout as JSON, like bench-net.
+//
+//Usage:
+//	./bench-scene [scene file] [frames]
+
+#include "Scene.hpp"
+#include "data_path.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdlib>
+
+typedef std::chrono::steady_clock Clock;
+
+static double seconds_since(Clock::time_point const &t) {
+	return std::chrono::duration< double >(Clock::now() - t).count();
+}
+
+struct Result {
+	RenderQueue::Stats stats;
+	double queue_us = 0.0; //queue_drawables() time per frame
+	bool sorted = true;
+};
+
+static Result measure(std::string const &scene_file, bool textured, uint32_t frames) {
+	std::unordered_map< std::string, uint32_t > mesh_ids;
+	Scene scene;
+	scene.load(scene_file, [&](Scene &scene, Scene::Transform *transform, std::string const &mesh_name) {
+		uint32_t id = mesh_ids.emplace(mesh_name, uint32_t(mesh_ids.size())).first->second;
+		scene.drawables.emplace_back(transform);
+		Scene::Drawable::Pipeline &pipeline = scene.drawables.back().pipeline;
+		pipeline.program = (textured ? 1 + id % 2 : 1);
+		pipeline.vao = 1;
+		pipeline.start = 0;
+		pipeline.count = 3;
+		pipeline.object_block = true;
+		if (textured) {
+			pipeline.textures[0].texture = 1 + id;
+			pipeline.textures[0].target = GL_TEXTURE_2D;
+			pipeline.material_block = true;
+			pipeline.material.TINT = glm::vec4(1.0f, 1.0f - 0.25f * (id % 4), 1.0f, 1.0f);
+		}
+	});
+
+	//look from the scene's camera, if it has one:
+	glm::mat4 world_to_clip = glm::mat4(1.0f);
+	if (!scene.cameras.empty()) {
+		Scene::Camera const &camera = scene.cameras.front();
+		world_to_clip = camera.make_projection() * glm::mat4(camera.transform->make_world_to_local());
+	}
+
+	Result result;
+	Scene::DrawQueue draw_queue;
+	auto start = Clock::now();
+	for (uint32_t f = 0; f < frames; ++f) {
+		scene.queue_drawables(world_to_clip, glm::mat4x3(1.0f), draw_queue);
+	}
+	result.queue_us = seconds_since(start) * 1e6 / std::max(1u, frames);
+
+	auto const &items = draw_queue.queue.items;
+	for (size_t i = 1; i < items.size(); ++i) {
+		if (items[i-1].key > items[i].key) result.sorted = false;
+	}
+	result.stats = Scene::count_state_calls(draw_queue);
+	return result;
+}
+
+int main(int argc, char **argv) {
+#ifdef _WIN32
+	//when compiled on windows, unhandled exceptions don't have their message printed, which can make debugging simple issues difficult.
+	try {
+#endif
+
+	if (argc > 3) {
+		std::cerr << "Usage:\n\t./bench-scene [scene file] [frames]" << std::endl;
+		return 1;
+	}
+	std::string scene_file = (argc >= 2 ? argv[1] : data_path("../dist/phone-bank.scene"));
+	uint32_t frames = (argc >= 3 ? uint32_t(std::atoi(argv[2])) : 1000);
+
+	Result show_scene = measure(scene_file, false, frames);
+	Result textured = measure(scene_file, true, frames);
+
+	auto result_json = [](Result const &r) {
+		RenderQueue::Stats const &s = r.stats;
+		return "{ \"draws\": " + std::to_string(s.draws)
+		     + ", \"programs\": " + std::to_string(s.programs)
+		     + ", \"vertex_arrays\": " + std::to_string(s.vertex_arrays)
+		     + ", \"textures\": " + std::to_string(s.textures)
+		     + ", \"active_textures\": " + std::to_string(s.active_textures)
+		     + ", \"calls\": " + std::to_string(s.calls())
+		     + ", \"unsorted_calls\": " + std::to_string(s.unsorted_calls)
+		     + ", \"saved\": " + std::to_string(int64_t(s.unsorted_calls) - int64_t(s.calls()))
+		     + ", \"buffer_ranges\": " + std::to_string(s.buffer_ranges)
+		     + ", \"uniforms\": " + std::to_string(s.uniforms)
+		     + ", \"unbatched_uniforms\": " + std::to_string(s.unbatched_uniforms)
+		     + ", \"materials\": " + std::to_string(s.materials)
+		     + ", \"queue_us\": " + std::to_string(r.queue_us) + " }";
+	};
+
+	bool sorted = show_scene.sorted && textured.sorted;
+	std::cout << "{\n"
+	          << "\t\"scene\": \"" << scene_file << "\",\n"
+	          << "\t\"frames\": " << frames << ",\n"
+	          << "\t\"show_scene\": " << result_json(show_scene) << ",\n"
+	          << "\t\"textured\": " << result_json(textured) << ",\n"
+	          << "\t\"sorted\": " << (sorted ? "true" : "false") << "\n"
+	          << "}" << std::endl;
+
+	return sorted ? 0 : 1;
+
+#ifdef _WIN32
+	} catch (std::exception const &e) {
+		std::cerr << "Unhandled exception:\n" << e.what() << std::endl;
+		return 1;
+	} catch (...) {
+		std::cerr << "Unhandled exception (unknown type)." << std::endl;
+		throw;
+	}
+#endif
+}
@@ -0,0 +1,319 @@
+//bench-sprites: microbenchmark for the client's per-frame sprite vertex generation
+// compares rebuilding every sprite each frame (background + walls + players + text,
+// which is what PlayMode::draw used to do) against rebuilding only the sprites
+// that move (players + text), with the level built once into a static buffer.
+// "Upload" is a copy into a buffer the size glBufferData would get, so no GL
+// context is needed.
+// Also counts how many axis-aligned quads per second each way of emitting them
+// manages (the old matrix-per-sprite code, append_sprite, and append_quads),
+// and how much of the level buffer camera culling (LevelGeometry::visible)
+// leaves to draw, on the level and on a copy tiled 'scale' x 'scale' times.
+// Results are printed to stdout as JSON, like bench-net.
+//
+//Usage:
+//	./bench-sprites [level file] [frames] [scale]
+
+#include "LevelGeometry.hpp"
+#include "data_path.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+
+typedef std::chrono::steady_clock Clock;
+
+static double seconds_since(Clock::time_point const &t) {
+	return std::chrono::duration< double >(Clock::now() - t).count();
+}
+
+//percentile of (sorted) samples:
+static double percentile(std::vector< double > const &sorted, double p) {
+	if (sorted.empty()) return 0.0;
+	size_t i = std::min(sorted.size() - 1, size_t(p * double(sorted.size())));
+	return sorted[i];
+}
+
+//append_sprite as it was before the axis-aligned path: three mat4s and four mat4 * vec4 per sprite
+static void append_sprite_matrices(std::vector< SpriteVertex > &vertices, glm::vec2 pos, glm::vec2 size, glm::vec2 tilepos, glm::vec2 tilesize, glm::u8vec4 color, float rotation, glm::vec2 tileset_size) {
+	glm::mat4 rotate_around_origin_mat = glm::mat4(
+		glm::vec4(glm::cos(rotation), -glm::sin(rotation), 0.0f, 0.0f),
+		glm::vec4(glm::sin(rotation), glm::cos(rotation), 0.0f, 0.0f),
+		glm::vec4(0.0f, 0.0f, 1.0f, 0.0f),
+		glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)
+	);
+	glm::vec2 center = pos + 0.5f * size;
+	glm::mat4 translate_to_origin_mat = glm::mat4(
+		glm::vec4(1.0f, 0.0f, 0.0f, 0.0f),
+		glm::vec4(0.0f, 1.0f, 0.0f, 0.0f),
+		glm::vec4(0.0f, 0.0f, 1.0f, 0.0f),
+		glm::vec4(-center.x, -center.y, 0.0f, 1.0f)
+	);
+	glm::mat4 translate_to_center_mat = glm::mat4(
+		glm::vec4(1.0f, 0.0f, 0.0f, 0.0f),
+		glm::vec4(0.0f, 1.0f, 0.0f, 0.0f),
+		glm::vec4(0.0f, 0.0f, 1.0f, 0.0f),
+		glm::vec4(center.x, center.y, 0.0f, 1.0f)
+	);
+	glm::mat4 m = translate_to_center_mat * rotate_around_origin_mat * translate_to_origin_mat;
+
+	tilepos = glm::vec2(tilepos.x * Level::TileSize / tileset_size.x, tilepos.y * Level::TileSize / tileset_size.y);
+	tilesize = glm::vec2(tilesize.x * Level::TileSize / tileset_size.x, tilesize.y * Level::TileSize / tileset_size.y);
+
+	glm::vec4 bot_left = m * glm::vec4(pos.x, pos.y, 0.0f, 1.0f);
+	glm::vec4 bot_right = m * glm::vec4(pos.x+size.x, pos.y, 0.0f, 1.0f);
+	glm::vec4 top_right = m * glm::vec4(pos.x+size.x, pos.y+size.y, 0.0f, 1.0f);
+	glm::vec4 top_left = m * glm::vec4(pos.x, pos.y+size.y, 0.0f, 1.0f);
+	vertices.emplace_back(glm::vec3(bot_left), color, glm::vec2(tilepos.x, tilepos.y));
+	vertices.emplace_back(glm::vec3(bot_right), color, glm::vec2(tilepos.x+tilesize.x, tilepos.y));
+	vertices.emplace_back(glm::vec3(top_right), color, glm::vec2(tilepos.x+tilesize.x, tilepos.y+tilesize.y));
+	vertices.emplace_back(glm::vec3(bot_left), color, glm::vec2(tilepos.x, tilepos.y));
+	vertices.emplace_back(glm::vec3(top_right), color, glm::vec2(tilepos.x+tilesize.x, tilepos.y+tilesize.y));
+	vertices.emplace_back(glm::vec3(top_left), color, glm::vec2(tilepos.x, tilepos.y+tilesize.y));
+}
+
+static bool same_vertices(std::vector< SpriteVertex > const &a, std::vector< SpriteVertex > const &b, float tolerance) {
+	if (a.size() != b.size()) return false;
+	for (size_t i = 0; i < a.size(); ++i) {
+		glm::vec3 d = a[i].Position - b[i].Position;
+		glm::vec2 t = a[i].TexCoord - b[i].TexCoord;
+		if (std::abs(d.x) > tolerance || std::abs(d.y) > tolerance || d.z != 0.0f) return false;
+		if (std::abs(t.x) > 1e-6f || std::abs(t.y) > 1e-6f) return false;
+		if (a[i].Color != b[i].Color) return false;
+	}
+	return true;
+}
+
+//culling results for a camera swept across a level:
+struct Culling {
+	size_t level_vertices = 0;
+	double visible_vertices = 0.0; //mean per frame
+	double ranges = 0.0; //mean per frame
+	double visible_ns = 0.0; //mean time for LevelGeometry::visible()
+	bool complete = true; //every wall on screen was in some range
+};
+
+static Culling measure_culling(Level const &level, glm::vec2 tileset_size) {
+	LevelGeometry geometry(level);
+	std::vector< SpriteVertex > vertices;
+	geometry.build(vertices, tileset_size);
+
+	Culling culling;
+	culling.level_vertices = vertices.size();
+
+	//same view as PlayMode: 640x640 window, one tile of margin
+	glm::vec2 radius = glm::vec2(320.0f + Level::TileSize);
+	glm::vec2 level_size = glm::vec2(float(level.width), float(level.height)) * float(Level::TileSize);
+	std::vector< int > first, count;
+	uint32_t views = 0;
+	double seconds = 0.0;
+	for (float y = 0.0f; y <= level_size.y; y += 37.0f) {
+		for (float x = 0.0f; x <= level_size.x; x += 37.0f) {
+			glm::vec2 camera = glm::vec2(x, y);
+			auto start = Clock::now();
+			geometry.visible(camera - radius, camera + radius, first, count);
+			seconds += seconds_since(start);
+			views += 1;
+			for (auto c : count) culling.visible_vertices += c;
+			culling.ranges += double(first.size());
+
+			//spot-check against brute force:
+			if (views % 13 == 0) {
+				for (size_t w = 0; w < geometry.walls.size(); ++w) {
+					auto const &wall = geometry.walls[w];
+					if (wall.pos.x + wall.size.x <= camera.x - radius.x || wall.pos.x >= camera.x + radius.x) continue;
+					if (wall.pos.y + wall.size.y <= camera.y - radius.y || wall.pos.y >= camera.y + radius.y) continue;
+					int v = int(6 * (LevelGeometry::BackgroundQuads + w));
+					bool found = false;
+					for (size_t r = 0; r < first.size(); ++r) {
+						if (v >= first[r] && v < first[r] + count[r]) found = true;
+					}
+					if (!found) culling.complete = false;
+				}
+			}
+		}
+	}
+	culling.visible_vertices /= views;
+	culling.ranges /= views;
+	culling.visible_ns = seconds * 1e9 / views;
+	return culling;
+}
+
+//roughly what PlayMode::drawPlayers + drawText emit with a full server:
+// eight players (one of them 'it', with its marker) and the net stats overlay
+static void build_dynamic(std::vector< SpriteVertex > &vertices, uint32_t frame, glm::vec2 tileset_size) {
+	glm::u8vec4 white = glm::u8vec4(255, 255, 255, 255);
+	for (uint32_t i = 0; i < 8; ++i) {
+		glm::vec2 pos = glm::vec2(float(100 + 60 * i), float(200 + (frame + 7 * i) % 300));
+		append_sprite(vertices, pos, glm::vec2(Level::TileSize), glm::vec2(1.0f, float(i % 4)), glm::vec2(1.0f, 1.0f), white, 0.0f, tileset_size);
+		if (i == frame / 600 % 8) {
+			append_sprite(vertices, pos - glm::vec2(0.0f, float(Level::TileSize)), glm::vec2(Level::TileSize), glm::vec2(1.0f, 4.0f), glm::vec2(1.0f, 1.0f), white, 0.0f, tileset_size);
+		}
+	}
+	//"GREEN IS IT", "RTT 000 MS JITTER 00 MS", "CLOCK AHEAD 000 MS" -- about 50 glyphs:
+	for (uint32_t i = 0; i < 50; ++i) {
+		append_sprite(vertices, glm::vec2(24.0f * float(i % 25), float(40 * (i / 25))), glm::vec2(22.0f, 26.0f), glm::vec2(float(i % 38) * (11.0f / 20.0f), 7.0f), glm::vec2(11.0f / 20.0f, 13.0f / 20.0f), white, 0.0f, tileset_size);
+	}
+}
+
+int main(int argc, char **argv) {
+#ifdef _WIN32
+	//when compiled on windows, unhandled exceptions don't have their message printed, which can make debugging simple issues difficult.
+	try {
+#endif
+
+	if (argc > 4) {
+		std::cerr << "Usage:\n\t./bench-sprites [level file] [frames] [scale]" << std::endl;
+		return 1;
+	}
+	std::string level_file = (argc >= 2 ? argv[1] : data_path("../dist/level_data"));
+	uint32_t frames = (argc >= 3 ? uint32_t(std::atoi(argv[2])) : 5000);
+	uint32_t scale = (argc >= 4 ? uint32_t(std::max(1, std::atoi(argv[3]))) : 4);
+
+	Level level(level_file);
+	LevelGeometry level_geometry(level);
+	glm::vec2 tileset_size = glm::vec2(160.0f, 160.0f);
+
+	//stands in for the GL buffer (sized generously so it never reallocates):
+	std::vector< SpriteVertex > uploaded;
+
+	//how PlayMode::draw used to work: everything, every frame
+	std::vector< double > all_us;
+	size_t all_vertices = 0;
+	{
+		std::vector< SpriteVertex > vertices;
+		for (uint32_t f = 0; f < frames; ++f) {
+			auto start = Clock::now();
+			vertices.clear();
+			level_geometry.build(vertices, tileset_size);
+			build_dynamic(vertices, f, tileset_size);
+			uploaded.assign(vertices.begin(), vertices.end());
+			all_us.emplace_back(seconds_since(start) * 1e6);
+		}
+		all_vertices = vertices.size();
+	}
+
+	//with the level in a static buffer: built + uploaded once, then only the moving sprites
+	size_t level_vertices = 0;
+	double level_build_us = 0.0;
+	{
+		std::vector< SpriteVertex > vertices;
+		auto start = Clock::now();
+		level_geometry.build(vertices, tileset_size);
+		uploaded.assign(vertices.begin(), vertices.end());
+		level_build_us = seconds_since(start) * 1e6;
+		level_vertices = vertices.size();
+	}
+	std::vector< double > dynamic_us;
+	size_t dynamic_vertices = 0;
+	{
+		std::vector< SpriteVertex > vertices;
+		for (uint32_t f = 0; f < frames; ++f) {
+			auto start = Clock::now();
+			vertices.clear();
+			build_dynamic(vertices, f, tileset_size);
+			uploaded.assign(vertices.begin(), vertices.end());
+			dynamic_us.emplace_back(seconds_since(start) * 1e6);
+		}
+		dynamic_vertices = vertices.size();
+	}
+
+	//quads per second, emitting every wall sprite (as tiles, the way LevelGeometry gets them) repeatedly:
+	std::vector< glm::vec2 > tileposes;
+	std::vector< SpriteQuad > quads;
+	for (auto const &wall : level_geometry.walls) {
+		tileposes.emplace_back(0.0f, float(wall.tile_variant));
+		SpriteQuad quad;
+		quad.pos = wall.pos;
+		quad.size = wall.size;
+		quad.tex = tileposes.back() * float(Level::TileSize) / tileset_size;
+		quad.tex_size = glm::vec2(float(Level::TileSize)) / tileset_size;
+		quad.color = glm::u8vec4(255, 255, 255, 255);
+		quads.emplace_back(quad);
+	}
+	uint32_t repeats = std::max(1u, frames / 10);
+	std::vector< SpriteVertex > matrices_out, sprite_out, scalar_out, simd_out;
+	auto quads_per_second = [&](std::vector< SpriteVertex > &out, auto &&emit) {
+		out.reserve(quads.size() * 6);
+		auto start = Clock::now();
+		for (uint32_t r = 0; r < repeats; ++r) {
+			out.clear();
+			emit(out);
+		}
+		return double(quads.size()) * repeats / seconds_since(start);
+	};
+	glm::u8vec4 white = glm::u8vec4(255, 255, 255, 255);
+	double matrices_qps = quads_per_second(matrices_out, [&](std::vector< SpriteVertex > &out) {
+		for (size_t i = 0; i < quads.size(); ++i) {
+			append_sprite_matrices(out, quads[i].pos, quads[i].size, tileposes[i], glm::vec2(1.0f, 1.0f), white, 0.0f, tileset_size);
+		}
+	});
+	double sprite_qps = quads_per_second(sprite_out, [&](std::vector< SpriteVertex > &out) {
+		for (size_t i = 0; i < quads.size(); ++i) {
+			append_sprite(out, quads[i].pos, quads[i].size, tileposes[i], glm::vec2(1.0f, 1.0f), white, 0.0f, tileset_size);
+		}
+	});
+	double scalar_qps = quads_per_second(scalar_out, [&](std::vector< SpriteVertex > &out) {
+		append_quads_scalar(out, quads.data(), quads.size());
+	});
+	double simd_qps = quads_per_second(simd_out, [&](std::vector< SpriteVertex > &out) {
+		append_quads(out, quads.data(), quads.size());
+	});
+	//the matrix path rounds positions a little differently; the others should agree exactly:
+	bool matches = same_vertices(matrices_out, sprite_out, 1e-3f)
+	            && same_vertices(sprite_out, scalar_out, 0.0f)
+	            && same_vertices(scalar_out, simd_out, 0.0f);
+
+	//camera culling, on the level and on a bigger one made of copies of it:
+	Culling culling = measure_culling(level, tileset_size);
+	std::vector< uint8_t > big_tiles(level.width * scale * level.height * scale);
+	for (uint32_t y = 0; y < level.height * scale; ++y) {
+		for (uint32_t x = 0; x < level.width * scale; ++x) {
+			big_tiles[y * level.width * scale + x] = level.tile(x % level.width, y % level.height);
+		}
+	}
+	Culling big_culling = measure_culling(Level(big_tiles, level.width * scale), tileset_size);
+	auto culling_json = [](Culling const &c) {
+		return "{ \"level_vertices\": " + std::to_string(c.level_vertices)
+		     + ", \"visible_vertices\": " + std::to_string(c.visible_vertices)
+		     + ", \"ranges\": " + std::to_string(c.ranges)
+		     + ", \"visible_ns\": " + std::to_string(c.visible_ns) + " }";
+	};
+
+	std::sort(all_us.begin(), all_us.end());
+	std::sort(dynamic_us.begin(), dynamic_us.end());
+	double all_p50 = percentile(all_us, 0.50);
+	double dynamic_p50 = percentile(dynamic_us, 0.50);
+	std::cout << "{\n"
+	          << "\t\"frames\": " << frames << ",\n"
+	          << "\t\"walls\": " << level_geometry.walls.size() << ",\n"
+	          << "\t\"level\": { \"vertices\": " << level_vertices << ", \"bytes\": " << level_vertices * sizeof(SpriteVertex) << ", \"build_us\": " << level_build_us << " },\n"
+	          << "\t\"rebuild_all\": { \"vertices_per_frame\": " << all_vertices << ", \"bytes_per_frame\": " << all_vertices * sizeof(SpriteVertex)
+	          << ", \"frame_us\": { \"p50\": " << all_p50 << ", \"p99\": " << percentile(all_us, 0.99) << " } },\n"
+	          << "\t\"static_level\": { \"vertices_per_frame\": " << dynamic_vertices << ", \"bytes_per_frame\": " << dynamic_vertices * sizeof(SpriteVertex)
+	          << ", \"frame_us\": { \"p50\": " << dynamic_p50 << ", \"p99\": " << percentile(dynamic_us, 0.99) << " } },\n"
+	          << "\t\"speedup\": " << (dynamic_p50 > 0.0 ? all_p50 / dynamic_p50 : 0.0) << ",\n"
+	          << "\t\"quads_per_second\": { \"matrices\": " << matrices_qps << ", \"append_sprite\": " << sprite_qps
+	          << ", \"append_quads_scalar\": " << scalar_qps << ", \"append_quads\": " << simd_qps << " },\n"
+	          << "\t\"append_quads_kernel\": \"" << append_quads_kernel() << "\",\n"
+	          << "\t\"culling\": " << culling_json(culling) << ",\n"
+	          << "\t\"culling_" << scale << "x" << scale << "\": " << culling_json(big_culling) << ",\n"
+	          << "\t\"matches\": " << (matches && culling.complete && big_culling.complete ? "true" : "false") << "\n"
+	          << "}" << std::endl;
+
+	return (matches && culling.complete && big_culling.complete) ? 0 : 1;
+
+#ifdef _WIN32
+	} catch (std::exception const &e) {
+		std::cerr << "Unhandled exception:\n" << e.what() << std::endl;
+		return 1;
+	} catch (...) {
+		std::cerr << "Unhandled exception (unknown type)." << std::endl;
+		throw;
+	}
+#endif
+}
@@ -14,6 +14,7 @@
 #include <stdexcept>
 #include <memory>
 #include <algorithm>
+#include <string>
 
 int main(int argc, char **argv) {
 #ifdef _WIN32
@@ -21,10 +22,12 @@ int main(int argc, char **argv) {
 	try {
 #endif
 	//------------ command line arguments ------------
-	if (argc != 3) {
-		std::cerr << "Usage:\n\t./client <host> <port>" << std::endl;
+	if (argc != 3 && !(argc == 4 && std::string(argv[3]) == "--net-thread")) {
+		std::cerr << "Usage:\n\t./client <host> <port> [--net-thread]" << std::endl;
 		return 1;
 	}
+	//service the connection on a background thread instead of once per frame:
+	bool use_net_thread = (argc == 4);
 
 	//------------ connect to server --------------
 	//Client client("2601:547:500:1fb0:c492:55ce:1790:55cd", "12345");
@@ -97,7 +100,7 @@ int main(int argc, char **argv) {
 	call_load_functions();
 
 	//------------ create game mode + make current --------------
-	Mode::set_current(std::make_shared< PlayMode >(client));
+	Mode::set_current(std::make_shared< PlayMode >(client, use_net_thread));
 
 	//------------ main loop ------------
 
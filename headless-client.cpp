@@ -0,0 +1,140 @@
+//headless-client: runs many simulated clients in one process, for load-testing a server
+// each bot is a Game (the client's simulation + networking, minus the drawing) driven by
+// random inputs; no window, OpenGL context, or SDL video is needed.
+// (the server seats at most 8 players, so clients past that are turned away and reported as lost)
+//
+//Usage:
+//	./headless-client <host> <port> [clients] [seconds]
+
+#include "Game.hpp"
+
+#include <chrono>
+#include <thread>
+#include <iostream>
+#include <sstream>
+#include <memory>
+#include <vector>
+#include <string>
+#include <random>
+#include <stdexcept>
+#include <cstdlib>
+
+typedef std::chrono::steady_clock Clock;
+
+//Client constructors chat on std::cout; keep that quiet when starting hundreds of them:
+struct MuteCout {
+	MuteCout() : old(std::cout.rdbuf(sink.rdbuf())) { }
+	~MuteCout() { std::cout.rdbuf(old); }
+	std::ostringstream sink;
+	std::streambuf *old;
+};
+
+struct Bot {
+	std::unique_ptr< Client > client;
+	std::unique_ptr< Game > game;
+	bool lost = false;
+	float next_decision = 0.0f; //seconds until the bot picks new inputs
+	uint32_t last_snapshots = 0; //game->snapshots_applied as of the last report
+};
+
+int main(int argc, char **argv) {
+#ifdef _WIN32
+	//when compiled on windows, unhandled exceptions don't have their message printed, which can make debugging simple issues difficult.
+	try {
+#endif
+
+	if (argc < 3 || argc > 5) {
+		std::cerr << "Usage:\n\t./headless-client <host> <port> [clients] [seconds]" << std::endl;
+		return 1;
+	}
+	uint32_t count = (argc >= 4 ? uint32_t(std::atoi(argv[3])) : 16);
+	double duration = (argc >= 5 ? std::atof(argv[4]) : 10.0);
+
+	//every bot's socket must fit in the connection backend's socket limit (with some left over for stdio etc):
+	uint32_t max_count = uint32_t(ConnectionMaxSockets > 64 ? ConnectionMaxSockets - 64 : 1);
+	if (count > max_count) {
+		std::cerr << "Backend '" << ConnectionBackend << "' handles " << ConnectionMaxSockets << " sockets; running " << max_count << " clients instead of " << count << "." << std::endl;
+		count = max_count;
+	}
+
+	std::vector< Bot > bots(count);
+	{
+		MuteCout mute;
+		for (auto &bot : bots) {
+			bot.client.reset(new Client(argv[1], argv[2]));
+			bot.game.reset(new Game(*bot.client));
+		}
+	}
+	std::cout << "Started " << bots.size() << " clients." << std::endl;
+
+	std::mt19937 mt(0xb075);
+	std::uniform_real_distribution< float > decision_time(0.1f, 0.8f);
+	std::uniform_int_distribution< int > choice(0, 5);
+
+	//run at a steady frame rate, like a vsync'd client:
+	constexpr float FrameTime = 1.0f / 60.0f;
+	auto start = Clock::now();
+	auto next_frame = start;
+	auto next_report = start + std::chrono::seconds(1);
+	uint32_t lost = 0;
+	while (std::chrono::duration< double >(Clock::now() - start).count() < duration) {
+		for (auto &bot : bots) {
+			if (bot.lost) continue;
+			Game &game = *bot.game;
+
+			bot.next_decision -= FrameTime;
+			if (bot.next_decision <= 0.0f) {
+				bot.next_decision = decision_time(mt);
+				int c = choice(mt);
+				game.left.pressed = (c == 0 || c == 1);
+				game.right.pressed = (c == 2 || c == 3);
+				game.space.pressed = (c == 1 || c == 3 || c == 4);
+			}
+
+			try {
+				game.update(FrameTime);
+			} catch (std::runtime_error const &) { //lost connection (or turned away by a full server)
+				bot.lost = true;
+				lost += 1;
+			}
+		}
+
+		auto now = Clock::now();
+		if (now >= next_report) {
+			next_report += std::chrono::seconds(1);
+			uint32_t alive = 0;
+			uint32_t snapshots = 0;
+			double rtt = 0.0;
+			for (auto &bot : bots) {
+				if (bot.lost) continue;
+				alive += 1;
+				snapshots += bot.game->snapshots_applied - bot.last_snapshots;
+				bot.last_snapshots = bot.game->snapshots_applied;
+				rtt += bot.game->server_clock.rtt;
+			}
+			std::cout << std::chrono::duration< double >(now - start).count() << "s:"
+			          << " " << alive << " connected (" << lost << " lost),"
+			          << " " << (alive ? double(snapshots) / alive : 0.0) << " snapshots/s per client,"
+			          << " mean rtt " << (alive ? rtt / alive * 1000.0 : 0.0) << "ms" << std::endl;
+		}
+
+		next_frame += std::chrono::duration_cast< Clock::duration >(std::chrono::duration< float >(FrameTime));
+		if (next_frame > now) {
+			std::this_thread::sleep_until(next_frame);
+		} else {
+			next_frame = now; //running behind; don't try to catch up
+		}
+	}
+
+	return 0;
+
+#ifdef _WIN32
+	} catch (std::exception const &e) {
+		std::cerr << "Unhandled exception:\n" << e.what() << std::endl;
+		return 1;
+	} catch (...) {
+		std::cerr << "Unhandled exception (unknown type)." << std::endl;
+		throw;
+	}
+#endif
+}
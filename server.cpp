@@ -1,9 +1,16 @@
 
 #include "Connection.hpp"
+#include "Level.hpp"
+#include "AABBSet.hpp"
+#include "PositionHistory.hpp"
+#include "NetClock.hpp"
+#include "SnapshotRate.hpp"
+#include "data_path.hpp"
 
 #include "hex_dump.hpp"
 
 #include <cstring>
+#include <cstdlib>
 #include <chrono>
 #include <stdexcept>
 #include <iostream>
@@ -18,18 +25,34 @@ int main(int argc, char **argv) {
 
 	//------------ argument parsing ------------
 
-	if (argc != 2) {
-		std::cerr << "Usage:\n\t./server <port>" << std::endl;
+	if (argc != 2 && argc != 3) {
+		std::cerr << "Usage:\n\t./server <port> [idle timeout (seconds, 0 to disable)]" << std::endl;
 		return 1;
 	}
 
+	//clients send at least a heartbeat every Game::HeartbeatInterval, so a
+	// connection that stays silent for much longer than that is presumed dead:
+	double idle_timeout = 5.0;
+	if (argc == 3) {
+		idle_timeout = std::atof(argv[2]);
+	}
+
 	//------------ initialization ------------
 
 	Server server(argv[1]);
+	server.idle_timeout = idle_timeout;
+
+	//same level file the clients load, used to reject positions inside walls:
+	Level level(data_path("level_data"));
+	std::cout << "Loaded " << level.width << "x" << level.height << " level." << std::endl;
 
 
 	//------------ main loop ------------
 	constexpr float ServerTick = 1.0f / 60.0f;
+	auto server_start = std::chrono::steady_clock::now();
+	//how often per-client network stats are logged (seconds):
+	constexpr double StatsInterval = 10.0;
+	double next_stats = StatsInterval;
 
 	//server state:
 	bool was_touching[8][8];
@@ -50,9 +73,16 @@ int main(int argc, char **argv) {
 		bool airborne = false;
 		bool sliding_left = false;
 		bool sliding_right = false;
+		uint32_t rejected_moves = 0; //'s' messages ignored for placing the player inside a wall
+		NetClock clock; //round-trip time, jitter, and clock offset estimates for this client
+		PositionHistory history; //position as of each recent tick
+		SnapshotRate snapshot_rate{1.0f / ServerTick}; //how often this client gets game state
 	};
 	std::unordered_map< Connection *, PlayerInfo > players;
 
+	//scratch space for the tag pass (kept to avoid reallocating every tick):
+	AABBSet seen_boxes; //where each player was as seen by one player
+
 	while (true) {
 		static auto next_tick = std::chrono::steady_clock::now() + std::chrono::duration< double >(ServerTick);
 		//process incoming data from clients until a tick has elapsed:
@@ -86,8 +116,8 @@ int main(int argc, char **argv) {
 
 					//remove them from the players list:
 					auto f = players.find(c);
-					occupiedColors[f->second.color] = false;
 					assert(f != players.end());
+					occupiedColors[f->second.color] = false;
 					players.erase(f);
 
 
@@ -113,8 +143,18 @@ int main(int argc, char **argv) {
 								return *reinterpret_cast<short *>(&data);
 							};
 
-							player.x = short_from_buf(c->recv_buffer, 1);
-							player.y = short_from_buf(c->recv_buffer, 3);
+							short x = short_from_buf(c->recv_buffer, 1);
+							short y = short_from_buf(c->recv_buffer, 3);
+							if (level.overlap(x, y, player.w, player.h) & Level::Solid) {
+								//keep the last valid position:
+								if (player.rejected_moves == 0) {
+									std::cout << "Rejecting position (" << x << ", " << y << ") inside a wall from player " << int(player.color) << "." << std::endl;
+								}
+								player.rejected_moves += 1;
+							} else {
+								player.x = x;
+								player.y = y;
+							}
 							uint8_t state = c->recv_buffer[5];
 							player.airborne = (state >> 2) & 1;
 							player.sliding_left = (state >> 1) & 1;
@@ -128,6 +168,12 @@ int main(int argc, char **argv) {
 							}
 							player.it = true;
 							c->recv_buffer.erase(c->recv_buffer.begin(), c->recv_buffer.begin() + 1);
+						} else if (type == 'h') { // heartbeat (only there to keep the connection from timing out)
+							c->recv_buffer.erase(c->recv_buffer.begin(), c->recv_buffer.begin() + 1);
+						} else if (type == 'q') { // ping
+							if (!NetClock::handle_ping(c)) break;
+						} else if (type == 'r') { // pong (answer to one of our pings)
+							if (!player.clock.handle_pong(c)) break;
 						} else {
 							std::cout << " unrecognized message received, type " + type << std::endl;
 							//shut down client connection:
@@ -139,18 +185,45 @@ int main(int argc, char **argv) {
 			}, remain);
 		}
 
-		auto collision = [](PlayerInfo p1, PlayerInfo p2) {
-			if (p1.x >= p2.x + p2.w || p1.x + p1.w <= p2.x || p1.y >= p2.y + p2.h || p1.y + p1.h <= p2.y) return false;
-			return true;
-		};
+		double now = std::chrono::duration< double >(std::chrono::steady_clock::now() - server_start).count();
 
-		//update current game state
+		//remember where everyone is as of this tick:
 		for (auto &[c, player] : players) {
-			(void)c; //work around "unused variable" warning on whatever version of g++ github actions is running
+			(void)c;
+			player.history.record(now, player.x, player.y);
+		}
 
-			// update collision matrix
+		//tags are judged from the players' points of view: each one's own latest position against
+		// where the other players were at the time it was looking at them
+		// (clients draw others a bit in the past, interpolating between snapshots):
+		uint32_t touching_as_seen_by[8] = {0, 0, 0, 0, 0, 0, 0, 0}; //bit j of [i]: i overlaps where it saw j
+		for (auto &[c, player] : players) {
+			(void)c;
+			double view_time = now - 0.5 * player.clock.rtt - player.snapshot_rate.interp_delay();
+			seen_boxes.resize(8);
+			for (auto &[c, other] : players) {
+				(void)c;
+				float x = other.x;
+				float y = other.y;
+				other.history.at(view_time, &x, &y);
+				seen_boxes.set(other.color, x, y, other.w, other.h);
+			}
+			touching_as_seen_by[player.color] = seen_boxes.overlap_mask(player.x, player.y, player.w, player.h);
+		}
+
+		//a pair is touching if either player saw the two overlap -- a measure that doesn't depend on
+		// who is "it", so it doesn't change when a tag flips "it" (and was_touching stays comparable
+		// from tick to tick; otherwise the new "it"'s lagged view could show the pair apart, then
+		// together again, and tag straight back):
+		for (auto &[c, player] : players) {
+			(void)c; //work around "unused variable" warning on whatever version of g++ github actions is running
 			for (auto &[c, other_player] : players) {
-				bool touching = collision(player, other_player);
+				(void)c;
+				//each unordered pair once, so a pair can't flip twice in one tick:
+				if (other_player.color <= player.color) continue;
+
+				bool touching = (touching_as_seen_by[player.color] & (1u << other_player.color)) != 0
+				             || (touching_as_seen_by[other_player.color] & (1u << player.color)) != 0;
 
 				if ((player.it || other_player.it) && touching && !was_touching[player.color][other_player.color]) {
 					player.it = !player.it;
@@ -163,8 +236,27 @@ int main(int argc, char **argv) {
 		}
 		//std::cout << status_message << std::endl; //DEBUG
 
+		if (now >= next_stats) {
+			next_stats = now + StatsInterval;
+			std::cout << "---- " << players.size() << " player(s) at " << now << "s ----\n";
+			for (auto &[c, player] : players) {
+				std::cout << "  player " << int(player.color) << " [" << c->socket << "]:"
+				          << " rtt " << player.clock.rtt * 1000.0f << "ms"
+				          << " jitter " << player.clock.jitter * 1000.0f << "ms"
+				          << " offset " << player.clock.offset * 1000.0 << "ms"
+				          << " (" << player.clock.samples << " samples)"
+				          << " snapshots " << player.snapshot_rate.rate << "Hz"
+				          << " rejected moves " << player.rejected_moves << "\n";
+			}
+			std::cout.flush();
+		}
+
 		//send updated game state to all clients
 		for (auto &[c, player] : players) {
+			bool due = player.snapshot_rate.due(now, ServerTick, c->send_buffer.size(), c->bytes_sent, player.clock.rtt);
+			player.clock.update(*c);
+			if (!due) continue;
+
 			c->send('a');
 			c->send(uint8_t(players.size()));
 			c->send(uint8_t(player.color));
@@ -222,6 +222,9 @@ int main(int argc, char **argv) {
 
 
 	//------------  teardown ------------
+	//the scene's uniform buffer goes with the context:
+	scene->release_draw_state();
+
 	SDL_GL_DeleteContext(context);
 	context = 0;
 